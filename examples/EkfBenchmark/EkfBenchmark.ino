@@ -0,0 +1,46 @@
+/*
+   Arduino sketch to measure the CPU cost of an AltitudeEstimator tick
+
+   A 1 kHz loop leaves 1000 usec per tick for everything else.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include "RFT_full.hpp"
+#include "rft_estimators/altitude.hpp"
+
+static const uint16_t TICKS = 1000;
+
+static rft::AltitudeEstimator ekf;
+
+void setup(void)
+{
+    Serial.begin(115200);
+}
+
+void loop(void)
+{
+    uint32_t start = micros();
+
+    for (uint16_t k=0; k<TICKS; ++k) {
+
+        ekf.predict(0.001, 0.01 * (k % 10));
+
+        // Baro at 50 Hz, rangefinder at 20 Hz with 20 msec latency
+        if (k % 20 == 0) {
+            ekf.updateBaro(0.001 * k);
+        }
+        if (k % 50 == 0) {
+            ekf.updateRange(0.001 * k, 0.95, 0.05, 0.02);
+        }
+    }
+
+    uint32_t usec = micros() - start;
+
+    Serial.print("usec per tick: ");
+    Serial.println(usec / (float)TICKS, 3);
+
+    delay(1000);
+}
@@ -0,0 +1,204 @@
+/*
+   Minimal timing support for host benchmarks
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <chrono>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace bench {
+
+    // Keeps the optimizer from discarding benchmarked results
+    static volatile float sink;
+
+    // Runs fun(k) for k in [0,n) and returns nanoseconds per call
+    template <typename F>
+    static double time(F fun, uint32_t n=1000000)
+    {
+        typedef std::chrono::steady_clock clock;
+
+        // Warm up caches and branch predictors
+        for (uint32_t k=0; k<n/10; ++k) {
+            fun(k);
+        }
+
+        clock::time_point start = clock::now();
+        for (uint32_t k=0; k<n; ++k) {
+            fun(k);
+        }
+        clock::time_point stop = clock::now();
+
+        return std::chrono::duration<double, std::nano>(stop-start).count() / n;
+    }
+
+    // Fastest of several runs, which is the least disturbed by the rest of
+    // the machine
+    template <typename F>
+    static double best(F fun, uint32_t n=200000, uint8_t runs=5)
+    {
+        double fastest = time(fun, n);
+
+        for (uint8_t r=1; r<runs; ++r) {
+            double ns = time(fun, n);
+            fastest = ns < fastest ? ns : fastest;
+        }
+
+        return fastest;
+    }
+
+    inline void report(const char * name, double nsPerOp)
+    {
+        printf("%-40s %10.2f ns/op %12.0f ops/sec\n",
+                name, nsPerOp, 1e9/nsPerOp);
+    }
+
+    // Timings by name, kept in a text file of "ns/op name" lines, against
+    // which a run is checked
+    class Baselines {
+
+        public:
+
+            static const uint16_t MAX = 128;
+            static const uint8_t NAMELEN = 64;
+
+        private:
+
+            char _names[MAX][NAMELEN] = {};
+            double _ns[MAX] = {};
+            uint16_t _count = 0;
+
+            uint16_t _regressions = 0;
+
+            double _scale = 1;
+
+            int16_t find(const char * name)
+            {
+                for (uint16_t k=0; k<_count; ++k) {
+                    if (!strcmp(_names[k], name)) {
+                        return k;
+                    }
+                }
+                return -1;
+            }
+
+        public:
+
+            bool load(const char * path)
+            {
+                FILE * fp = fopen(path, "r");
+
+                if (!fp) {
+                    return false;
+                }
+
+                char line[128];
+
+                while (_count < MAX && fgets(line, sizeof(line), fp)) {
+
+                    if (line[0] == '#') {
+                        continue;
+                    }
+
+                    double ns = 0;
+                    char name[NAMELEN] = {};
+
+                    if (sscanf(line, "%lf %63[^\n]", &ns, name) == 2) {
+                        set(name, ns);
+                    }
+                }
+
+                fclose(fp);
+
+                return true;
+            }
+
+            bool save(const char * path, const char * comment)
+            {
+                FILE * fp = fopen(path, "w");
+
+                if (!fp) {
+                    return false;
+                }
+
+                fprintf(fp, "# %s\n", comment);
+
+                for (uint16_t k=0; k<_count; ++k) {
+                    fprintf(fp, "%.2f %s\n", _ns[k], _names[k]);
+                }
+
+                fclose(fp);
+
+                return true;
+            }
+
+            void set(const char * name, double ns)
+            {
+                int16_t k = find(name);
+
+                if (k < 0 && _count < MAX) {
+                    k = _count++;
+                    snprintf(_names[k], NAMELEN, "%s", name);
+                }
+
+                if (k >= 0) {
+                    _ns[k] = ns;
+                }
+            }
+
+            // Speed of this machine now relative to when the baselines were
+            // saved, from timing the same reference code; returns the ratio
+            // by which later checks are scaled
+            double calibrate(const char * name, double ns)
+            {
+                int16_t k = find(name);
+
+                _scale = k < 0 ? 1 : ns / _ns[k];
+
+                return _scale;
+            }
+
+            // Fractional change from the baseline, scaled by calibrate(); 0
+            // if there is none
+            double change(const char * name, double ns)
+            {
+                int16_t k = find(name);
+
+                return k < 0 ? 0 : ns / _scale / _ns[k] - 1;
+            }
+
+            // Prints the change from the baseline and counts it as a
+            // regression if slower by more than threshold (a fraction)
+            void check(const char * name, double ns, double threshold)
+            {
+                int16_t k = find(name);
+
+                if (k < 0) {
+                    printf("    (no baseline)\n");
+                    return;
+                }
+
+                double c = change(name, ns);
+
+                bool regressed = c > threshold;
+
+                printf("    %+6.1f%% vs %.2f ns/op%s\n", 100*c, _ns[k],
+                        regressed ? "  REGRESSION" : "");
+
+                _regressions += regressed;
+            }
+
+            uint16_t regressions(void)
+            {
+                return _regressions;
+            }
+
+    }; // class Baselines
+
+} // namespace bench
@@ -0,0 +1,127 @@
+/*
+   A fourth-order Butterworth low-pass on a three-axis gyro: one
+   BiquadCascade for all axes versus two BiquadFilter sections per axis
+
+   Checks that both give the same output, that the constexpr design matches
+   the one computed at run time and has the Butterworth response, and
+   reports the storage and cost per sample of each, and of a four-axis
+   cascade, whose rows fill a host vector register.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include <math.h>
+
+#include "RFT_filters.hpp"
+#include "bench.hpp"
+
+static const float RATE = 1000;
+static const float CUTOFF = 80;
+
+// Computed by the compiler
+static constexpr rft::BiquadCoefficients LPF[2] = {
+    rft::BiquadCoefficients::butterworth(CUTOFF, RATE, 2, 0),
+    rft::BiquadCoefficients::butterworth(CUTOFF, RATE, 2, 1)
+};
+
+static rft::BiquadCascade<3, 2> cascade(LPF);
+static rft::BiquadCascade<4, 2> cascade4(LPF);
+
+static rft::BiquadFilter scalar[3][2];
+
+static void scalarUpdate(const float * in, float * out)
+{
+    for (uint8_t a=0; a<3; ++a) {
+        out[a] = scalar[a][1].update(scalar[a][0].update(in[a]));
+    }
+}
+
+static float samples[1024][4];
+
+// Gain of the cascade at f Hz
+static float gain(float f)
+{
+    cascade.begin();
+
+    float sum = 0;
+    uint32_t count = 0;
+
+    for (uint32_t k=0; k<4*RATE; ++k) {
+        float x = sinf(2 * M_PI * f * k / RATE);
+        float in[3] = {x, x, x};
+        float out[3] = {};
+        cascade.update(in, out);
+        if (k > RATE) {
+            sum += out[2] * out[2];
+            count++;
+        }
+    }
+
+    return sqrtf(2 * sum / count);
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    // Run-time design of the same two sections, with FastMath's sine and
+    // cosine and the Butterworth Qs written out
+    for (uint8_t a=0; a<3; ++a) {
+        scalar[a][0].setLowPass(CUTOFF, RATE, 1.306563f);
+        scalar[a][1].setLowPass(CUTOFF, RATE, 0.541196f);
+    }
+
+    for (uint16_t k=0; k<1024; ++k) {
+        for (uint8_t a=0; a<4; ++a) {
+            samples[k][a] = sinf(0.05f * k + a) + 0.3f * sinf(2.1f * k * (a+1));
+        }
+    }
+
+    float error = 0;
+    for (uint32_t k=0; k<10000; ++k) {
+        float y1[3] = {}, y2[3] = {};
+        cascade.update(samples[k&1023], y1);
+        scalarUpdate(samples[k&1023], y2);
+        for (uint8_t a=0; a<3; ++a) {
+            float e = fabsf(y1[a] - y2[a]);
+            error = e > error ? e : error;
+        }
+    }
+
+    printf("largest difference, cascade vs scalar: %g\n\n", error);
+
+    printf("gain at  40 Hz: %6.2f dB\n", 20 * log10f(gain(40)));
+    printf("gain at  80 Hz: %6.2f dB (Butterworth -3.01)\n",
+            20 * log10f(gain(CUTOFF)));
+    printf("gain at 160 Hz: %6.2f dB\n", 20 * log10f(gain(160)));
+    printf("gain at 320 Hz: %6.2f dB\n\n", 20 * log10f(gain(320)));
+
+    printf("storage, 3 x 2 BiquadFilter:   %3u bytes\n",
+            (unsigned)sizeof(scalar));
+    printf("storage, BiquadCascade<3,2>:   %3u bytes + %u of constexpr "
+            "coefficients\n\n", (unsigned)sizeof(cascade),
+            (unsigned)sizeof(LPF));
+
+    bench::report("3 x 2 BiquadFilter", bench::best([](uint32_t k) {
+                float out[3];
+                scalarUpdate(samples[k&1023], out);
+                bench::sink = out[0];
+                }));
+
+    bench::report("BiquadCascade<3,2>", bench::best([](uint32_t k) {
+                float out[3];
+                cascade.update(samples[k&1023], out);
+                bench::sink = out[0];
+                }));
+
+    bench::report("BiquadCascade<4,2>", bench::best([](uint32_t k) {
+                float out[4];
+                cascade4.update(samples[k&1023], out);
+                bench::sink = out[0];
+                }));
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+   Decimating an 8 kHz three-axis gyro to 500 Hz: CIC/FIR Decimator versus
+   a LowPassFilter boxcar on each axis, read every sixteenth sample
+
+   Reports each one's gain for tones in the passband and for vibration that
+   aliases into it, and its cost per input sample.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include <math.h>
+
+#include "RFT_filters.hpp"
+#include "RFT_decimator.hpp"
+#include "bench.hpp"
+
+static const float RATE = 8000;
+
+// MPU-6000 at 2000 deg/s full scale
+static const float LSB = 1 / 16.4f * M_PI / 180;
+
+typedef rft::Decimator<3> GyroDecimator;
+
+static const uint16_t RATIO = GyroDecimator::RATIO;
+
+// Output amplitude over input amplitude for a tone at f Hz
+template <typename F>
+static float gain(F decimate, float f)
+{
+    static const uint32_t SAMPLES = 2 * RATE;
+    static const uint32_t SETTLE = SAMPLES / 10;
+
+    float sum = 0;
+    uint32_t count = 0;
+
+    for (uint32_t k=0; k<SAMPLES; ++k) {
+
+        float x = sinf(2 * M_PI * f * k / RATE);
+        float in[3] = {x, x, x};
+        float out[3] = {};
+
+        if (decimate(in, out) && k > SETTLE) {
+            sum += out[0] * out[0];
+            count++;
+        }
+    }
+
+    // RMS of a unit sine is 1/sqrt(2)
+    return sqrtf(2 * sum / count);
+}
+
+static rft::LowPassFilter boxcars[3] = {
+    rft::LowPassFilter(RATIO), rft::LowPassFilter(RATIO), rft::LowPassFilter(RATIO)
+};
+
+static uint32_t boxcarCount = 0;
+
+static bool boxcar(const float * in, float * out)
+{
+    for (uint8_t a=0; a<3; ++a) {
+        out[a] = boxcars[a].update(in[a]);
+    }
+
+    return ++boxcarCount % RATIO == 0;
+}
+
+static GyroDecimator decimator(LSB);
+
+static bool cicfir(const float * in, float * out)
+{
+    return decimator.update(in, out);
+}
+
+static void compare(const char * label, float f)
+{
+    for (uint8_t a=0; a<3; ++a) {
+        boxcars[a].begin();
+    }
+    decimator.begin();
+
+    float g1 = gain(boxcar, f);
+    float g2 = gain(cicfir, f);
+
+    printf("%-28s %7.0f Hz  %8.1f dB  %8.1f dB\n", label, f,
+            20 * log10f(g1), 20 * log10f(g2));
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    float out = RATE / RATIO;
+
+    printf("%.0f Hz in, %.0f Hz out\n\n", RATE, out);
+
+    printf("%-28s %10s  %11s  %11s\n", "", "", "boxcar", "CIC/FIR");
+
+    compare("passband", 10);
+    compare("passband", 50);
+    compare("passband", 100);
+
+    // Vibration that lands at 40 Hz after decimation
+    compare("aliases to 40 Hz", out - 40);
+    compare("aliases to 40 Hz", 2 * out + 40);
+    compare("aliases to 40 Hz", 5 * out - 40);
+    compare("aliases to 40 Hz", 8 * out + 40);
+
+    printf("\n");
+
+    static float samples[1024][3];
+    static int16_t raw[1024][3];
+    for (uint16_t k=0; k<1024; ++k) {
+        for (uint8_t a=0; a<3; ++a) {
+            samples[k][a] = sinf(0.01f * k + a);
+            raw[k][a] = (int16_t)(samples[k][a] / LSB);
+        }
+    }
+
+    bench::report("3 x LowPassFilter, per sample", bench::time([](uint32_t k) {
+                float out[3];
+                boxcar(samples[k&1023], out);
+                bench::sink = out[0];
+                }));
+
+    bench::report("Decimator, float, per sample", bench::time([](uint32_t k) {
+                float out[3] = {};
+                decimator.update(samples[k&1023], out);
+                bench::sink = out[0];
+                }));
+
+    bench::report("Decimator, raw, per sample", bench::time([](uint32_t k) {
+                float out[3] = {};
+                decimator.update(raw[k&1023], out);
+                bench::sink = out[0];
+                }));
+
+    return 0;
+}
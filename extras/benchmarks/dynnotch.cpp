@@ -0,0 +1,172 @@
+/*
+   Dynamic notch filters on a 2 kHz gyro with motor vibration sweeping from
+   120 to 200 Hz, plus its second harmonic
+
+   Reports how much of the vibration each axis keeps with the dynamic notches,
+   with a fixed notch at the starting frequency, and with none, and what the
+   analysis costs per tick compared with running it all in one tick.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include <math.h>
+
+#include "RFT_filters.hpp"
+#include "RFT_dynnotch.hpp"
+#include "bench.hpp"
+
+static const float RATE = 2000;
+
+static const float SECONDS = 6;
+
+typedef rft::DynamicNotch<64, 2> Notch;
+
+// Sensor noise, uniform in [-0.02, +0.02] and repeatable for each sample
+static float noise(uint32_t k, uint8_t axis)
+{
+    uint32_t h = (k * 3 + axis) * 2654435761u;
+    h ^= h >> 15;
+    h *= 2246822519u;
+    h ^= h >> 13;
+    return 0.04f * (h / 4294967296.f - 0.5f);
+}
+
+// Pilot input and noise, which the notches should leave alone
+static float clean(uint32_t k, uint8_t axis)
+{
+    float t = k / RATE;
+    return 0.5f * sinf(2 * M_PI * 1.5f * t + axis) +
+        0.2f * sinf(2 * M_PI * 7 * t) + noise(k, axis);
+}
+
+// Fundamental rising linearly from 120 to 200 Hz, with the phase integrated
+static float vibration(uint32_t k, uint8_t axis)
+{
+    float t = k / RATE;
+    float phase = 2 * M_PI * (120 * t + 0.5f * (80 / SECONDS) * t * t);
+    return (0.3f + 0.1f * axis) * sinf(phase) + 0.15f * sinf(2 * phase + axis);
+}
+
+// Vibration left in the output relative to that in the input, in dB, after
+// the first second
+template <typename F>
+static float residual(F filter)
+{
+    static const uint32_t SAMPLES = SECONDS * RATE;
+
+    double in = 0, out = 0;
+
+    for (uint32_t k=0; k<SAMPLES; ++k) {
+
+        float gyro[3] = {};
+        for (uint8_t a=0; a<3; ++a) {
+            gyro[a] = clean(k, a) + vibration(k, a);
+        }
+
+        filter(gyro);
+
+        if (k > RATE) {
+            for (uint8_t a=0; a<3; ++a) {
+                float v = vibration(k, a);
+                float e = gyro[a] - clean(k, a);
+                in += v * v;
+                out += e * e;
+            }
+        }
+    }
+
+    return 10 * log10(out / in);
+}
+
+static Notch notch(RATE, 80, 900);
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    printf("%.0f Hz gyro, %d-point FFT, %d ticks per axis analyzed\n\n",
+            RATE, 64, Notch::STEPS);
+
+    float none = residual([](float * gyro) { (void)gyro; });
+
+    static rft::BiquadFilter fixed[3][2];
+    for (uint8_t a=0; a<3; ++a) {
+        fixed[a][0].setNotch(120, RATE, 3);
+        fixed[a][1].setNotch(240, RATE, 3);
+    }
+
+    float still = residual([](float * gyro) {
+            for (uint8_t a=0; a<3; ++a) {
+                gyro[a] = fixed[a][1].update(fixed[a][0].update(gyro[a]));
+            }
+            });
+
+    notch.begin();
+    float dynamic = residual([](float * gyro) { notch.update(gyro); });
+
+    printf("%-40s %8.1f dB\n", "vibration left, no notch", none);
+    printf("%-40s %8.1f dB\n", "vibration left, fixed 120/240 Hz", still);
+    printf("%-40s %8.1f dB\n", "vibration left, dynamic", dynamic);
+    for (uint8_t a=0; a<3; ++a) {
+        printf("final centers, axis %d %24.0f %5.0f Hz (true 200 400)\n", a,
+                notch.center(a, 0), notch.center(a, 1));
+    }
+    printf("\n");
+
+    static float samples[1024][3];
+    for (uint16_t k=0; k<1024; ++k) {
+        for (uint8_t a=0; a<3; ++a) {
+            samples[k][a] = clean(k, a) + vibration(k, a);
+        }
+    }
+
+    double tick = bench::best([](uint32_t k) {
+            float gyro[3] = {samples[k&1023][0], samples[k&1023][1],
+                             samples[k&1023][2]};
+            notch.update(gyro);
+            bench::sink = gyro[0];
+            });
+
+    bench::report("DynamicNotch::update, mean per tick", tick);
+
+    // Each tick of an analysis cycle on its own, at its fastest over many
+    // cycles; the clock adds a few tens of nanoseconds to each
+    typedef std::chrono::steady_clock clock;
+
+    static const uint8_t CYCLE = 3 * Notch::STEPS;
+
+    double fastest[CYCLE];
+    for (uint8_t j=0; j<CYCLE; ++j) {
+        fastest[j] = 1e9;
+    }
+
+    for (uint32_t k=0; k<20000*CYCLE; ++k) {
+
+        float gyro[3] = {samples[k&1023][0], samples[k&1023][1],
+                         samples[k&1023][2]};
+
+        clock::time_point start = clock::now();
+        notch.update(gyro);
+        clock::time_point stop = clock::now();
+
+        bench::sink = gyro[0];
+
+        double ns = std::chrono::duration<double, std::nano>(stop-start).count();
+        uint8_t j = k % CYCLE;
+        fastest[j] = ns < fastest[j] ? ns : fastest[j];
+    }
+
+    double slowest = 0, axis = 0;
+    for (uint8_t j=0; j<CYCLE; ++j) {
+        slowest = fastest[j] > slowest ? fastest[j] : slowest;
+        axis += j < Notch::STEPS ? fastest[j] : 0;
+    }
+
+    bench::report("slowest tick", slowest);
+    bench::report("one axis's analysis in a single tick", axis);
+
+    return 0;
+}
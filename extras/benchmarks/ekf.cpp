@@ -0,0 +1,82 @@
+/*
+   CPU cost of one AltitudeEstimator tick, with an accuracy check on a
+   simulated climb
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "rft_estimators/altitude.hpp"
+#include "bench.hpp"
+
+static const float DT = 0.001; // 1 kHz
+
+static float noise(float stdDev)
+{
+    // Sum of uniforms approximates a Gaussian
+    float sum = 0;
+    for (uint8_t k=0; k<12; ++k) {
+        sum += rand() / (float)RAND_MAX;
+    }
+    return stdDev * (sum - 6);
+}
+
+static void accuracy(void)
+{
+    rft::AltitudeEstimator ekf;
+
+    float z = 0, dz = 0, err2 = 0;
+    uint32_t n = 10000;
+
+    for (uint32_t k=0; k<n; ++k) {
+
+        // Aggressive climb: 5 m/s^2 for one second, then coast
+        float a = k < 1000 ? 5 : 0;
+        z += dz * DT + 0.5f * a * DT * DT;
+        dz += a * DT;
+
+        ekf.predict(DT, a + 0.2f + noise(0.3));
+
+        if (k % 20 == 0) {
+            ekf.updateBaro(z + noise(0.5));
+        }
+
+        float e = ekf.altitude() - z;
+        err2 += e * e;
+    }
+
+    printf("AltitudeEstimator RMS altitude error %.3f m over %.0f m climb\n",
+            sqrt(err2/n), z);
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    accuracy();
+
+    static rft::AltitudeEstimator ekf;
+
+    bench::report("AltitudeEstimator predict", bench::time([](uint32_t k) {
+                ekf.predict(DT, 1e-3f*(k&1023));
+                bench::sink = ekf.altitude();
+                }));
+
+    bench::report("AltitudeEstimator updateBaro", bench::time([](uint32_t k) {
+                ekf.updateBaro(1e-3f*(k&1023));
+                bench::sink = ekf.altitude();
+                }));
+
+    bench::report("AltitudeEstimator updateRange delayed",
+            bench::time([](uint32_t k) {
+                ekf.updateRange(1e-3f*(k&1023), 0.9, 0.05, 0.01);
+                bench::sink = ekf.altitude();
+                }));
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+/*
+   Error sweep and timing for the RFT_FASTMATH tiers against libm
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include <math.h>
+
+#include "RFT_fastmath.hpp"
+#include "bench.hpp"
+
+static const uint32_t SWEEP = 200000;
+
+static float sweep(float lo, float hi, uint32_t k)
+{
+    return lo + (hi - lo) * k / (SWEEP-1);
+}
+
+template <uint8_t T>
+static void errors(void)
+{
+    typedef rft::FastMathTier<T> M;
+
+    double eatan = 0, easin = 0, esin = 0, ecos = 0, einv = 0;
+
+    for (uint32_t k=0; k<SWEEP; ++k) {
+
+        // atan2 around the unit circle at several radii
+        float a = sweep(-M_PI, +M_PI, k);
+        float r = 0.01f + (k % 7);
+        float y = r * sinf(a);
+        float x = r * cosf(a);
+        eatan = fmax(eatan, fabs(M::atan2(y, x) - atan2(y, x)));
+
+        float u = sweep(-1, +1, k);
+        easin = fmax(easin, fabs(M::asin(u) - asin(u)));
+
+        float t = sweep(-4*M_PI, +4*M_PI, k);
+        float s = 0, c = 0;
+        M::sincos(t, s, c);
+        esin = fmax(esin, fabs(s - sin(t)));
+        ecos = fmax(ecos, fabs(c - cos(t)));
+
+        float v = sweep(1e-4f, 1e+4f, k);
+        einv = fmax(einv, fabs(M::invSqrt(v) * sqrt(v) - 1));
+    }
+
+    printf("tier %d max error: atan2 %.1e  asin %.1e  sin %.1e  cos %.1e  "
+           "invSqrt (rel) %.1e\n", T, eatan, easin, esin, ecos, einv);
+}
+
+template <uint8_t T>
+static void timing(void)
+{
+    typedef rft::FastMathTier<T> M;
+
+    char name[100];
+
+    snprintf(name, sizeof(name), "tier %d atan2", T);
+    bench::report(name, bench::time([](uint32_t k) {
+                bench::sink = M::atan2(1e-3f*(k&1023) - 0.5f, 0.3f);
+                }));
+
+    snprintf(name, sizeof(name), "tier %d asin", T);
+    bench::report(name, bench::time([](uint32_t k) {
+                bench::sink = M::asin(1e-3f*(k&1023) - 0.5f);
+                }));
+
+    snprintf(name, sizeof(name), "tier %d sincos", T);
+    bench::report(name, bench::time([](uint32_t k) {
+                float s = 0, c = 0;
+                M::sincos(1e-2f*(k&1023) - 5, s, c);
+                bench::sink = s + c;
+                }));
+
+    snprintf(name, sizeof(name), "tier %d invSqrt", T);
+    bench::report(name, bench::time([](uint32_t k) {
+                bench::sink = M::invSqrt(1e-2f*(k&1023) + 0.1f);
+                }));
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    errors<0>();
+    errors<1>();
+    errors<2>();
+
+    printf("\n");
+
+    timing<0>();
+    timing<1>();
+    timing<2>();
+
+    return 0;
+}
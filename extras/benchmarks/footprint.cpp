@@ -0,0 +1,323 @@
+/*
+   RAM footprint of a small firmware on the host: an RFT with a filtered
+   sensor, two controllers, a parameter store and a serial task, run for a
+   simulated second and then asked for its footprint over MSP, as
+   extras/footprint/footprint.py does.  Prints the table and what sampling
+   the stack costs.  With a filename argument, also writes the replies there
+   for footprint.py -f.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include "rft_boards/realboards/linux_serial.hpp" // host micros(), delay()
+#include "RFT_full.hpp"
+#include "RFT_filters.hpp"
+#include "bench.hpp"
+
+static const uint8_t FOOTPRINT_GET = 219;
+
+static const float DT = 0.001;
+
+// A board whose serial port is a pair of memory queues, on a simulated clock
+class HostBoard : public rft::RealBoard {
+
+    public:
+
+        uint8_t rx[256] = {};
+        uint8_t rxHead = 0;
+        uint8_t rxTail = 0;
+
+        uint8_t tx[4096] = {};
+        uint16_t txCount = 0;
+
+        float now = 0;
+
+        float getTime(void) override
+        {
+            return now;
+        }
+
+        void request(int16_t index)
+        {
+            uint8_t size = 2;
+            uint8_t lo = index & 0xFF, hi = index >> 8;
+            const uint8_t msg[] = {'$', 'M', '<', size, FOOTPRINT_GET, lo, hi,
+                (uint8_t)(size ^ FOOTPRINT_GET ^ lo ^ hi)};
+            for (uint8_t k=0; k<sizeof(msg); ++k) {
+                rx[rxTail++] = msg[k];
+            }
+        }
+
+    protected:
+
+        void setLed(bool isOn) override
+        {
+            (void)isOn;
+        }
+
+        uint8_t serialAvailable(bool secondaryPort) override
+        {
+            (void)secondaryPort;
+            return rxTail - rxHead;
+        }
+
+        uint8_t serialRead(bool secondaryPort) override
+        {
+            (void)secondaryPort;
+            return rx[rxHead++];
+        }
+
+        void serialWrite(uint8_t c, bool secondaryPort) override
+        {
+            (void)secondaryPort;
+            if (txCount < sizeof(tx)) {
+                tx[txCount++] = c;
+            }
+        }
+};
+
+class HostState : public rft::State {
+
+    public:
+
+        bool safeToArm(void) override { return true; }
+};
+
+class NullActuator : public rft::Actuator {
+
+    protected:
+
+        void run(float * demands, bool olcInactive) override
+        {
+            (void)demands;
+            (void)olcInactive;
+        }
+};
+
+class Receiver : public rft::OpenLoopController {
+
+    protected:
+
+        void getDemands(float * demands) override
+        {
+            demands[0] = 0;
+        }
+
+        bool inactive(void) override
+        {
+            return true;
+        }
+
+        bool inArmedState(void) override
+        {
+            return false;
+        }
+};
+
+// A barometer averaged over twenty samples, logging now and then
+class Baro : public rft::Sensor {
+
+    private:
+
+        rft::LowPassFilter _filter = rft::LowPassFilter(20);
+
+        uint32_t _count = 0;
+
+    public:
+
+        void addFootprint(rft::Footprint & footprint)
+        {
+            _filter.addFootprint(footprint);
+        }
+
+    protected:
+
+        void begin(void) override
+        {
+            _filter.begin();
+        }
+
+        void modifyState(rft::State * state, float time) override
+        {
+            (void)state;
+
+            float altitude = _filter.update(time);
+
+            if (++_count % 100 == 0) {
+                RFT_LOG("altitude %f\n", altitude);
+            }
+        }
+};
+
+class Controller : public rft::ClosedLoopController {
+
+    protected:
+
+        void modifyDemands(rft::State * state, float * demands) override
+        {
+            (void)state;
+            demands[0] += 1;
+        }
+};
+
+// What msppg generates for FOOTPRINT_GET
+class FootprintTask : public rft::SerialTask {
+
+    private:
+
+        uint8_t _payload[128] = {};
+
+    protected:
+
+        void collectPayload(uint8_t index, uint8_t value) override
+        {
+            _payload[index] = value;
+        }
+
+        void dispatchMessage(uint8_t command) override
+        {
+            if (command == FOOTPRINT_GET) {
+                int16_t index = 0;
+                memcpy(&index, _payload, 2);
+                sendFootprint(index);
+            }
+        }
+};
+
+class Firmware : public rft::RFT {
+
+    public:
+
+        Firmware(rft::Board * b, rft::OpenLoopController * r,
+                 rft::Actuator * a)
+            : RFT(b, r, a) { }
+
+        void begin(void) { RFT::begin(); }
+
+        void update(rft::State * state) { RFT::update(state); }
+
+        void addSerialTask(rft::SerialTask * task)
+        {
+            RFT::addSerialTask(task);
+        }
+};
+
+static HostBoard board;
+static HostState state;
+
+// Runs the firmware until the serial task has had a tick
+static void tick(Firmware & firmware, float seconds)
+{
+    for (float end = board.now + seconds; board.now < end; ) {
+        board.now += DT;
+        firmware.update(&state);
+    }
+}
+
+static uint32_t get32(const uint8_t * p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Start of the first footprint reply at or after k, or txCount
+static uint16_t next(uint16_t k)
+{
+    while (k+5 < board.txCount && board.tx[k+4] != rft::Footprint::MSP_ID) {
+        k += 6 + board.tx[k+3];
+    }
+
+    return k+5 < board.txCount ? k : board.txCount;
+}
+
+static const uint8_t * find(uint16_t k)
+{
+    k = next(k);
+
+    return k < board.txCount ? &board.tx[k+5] : NULL;
+}
+
+int main(int argc, char ** argv)
+{
+    Receiver receiver;
+    NullActuator actuator;
+    Baro baro;
+    Controller level, hold;
+    FootprintTask task;
+
+    rft::ParameterStore parameters;
+    parameters.addFloat("level.gain", 0.5, 0, 10);
+    parameters.addFloat("hold.gain", 1.5, 0, 10);
+
+    Firmware firmware(&board, &receiver, &actuator);
+    firmware.addSensor(&baro);
+    firmware.addClosedLoopController(&level);
+    firmware.addClosedLoopController(&hold, 1);
+    firmware.setParameters(&parameters);
+    firmware.addSerialTask(&task);
+
+    baro.addFootprint(firmware.footprint());
+
+    firmware.begin();
+
+    tick(firmware, 1);
+
+    // Entry 0 tells how many there are
+    board.txCount = 0;
+    uint8_t count = 1;
+    for (uint8_t index=0; index<count; ++index) {
+        uint16_t start = board.txCount;
+        board.request(index);
+        tick(firmware, 0.05);
+        const uint8_t * reply = find(start);
+        count = reply ? reply[1] : 0;
+    }
+
+    printf("%-20s %8s %8s %8s %8s\n", "", "size", "buffer", "used",
+            "unused");
+
+    uint32_t total = 0, unused = 0;
+
+    // Log records are interleaved with the replies
+    for (uint16_t k=0; (k = next(k)) < board.txCount; k += 6 + board.tx[k+3]) {
+
+        uint8_t size = board.tx[k+3];
+        const uint8_t * payload = &board.tx[k+5];
+
+        uint32_t bytes = get32(payload+2);
+        uint32_t capacity = get32(payload+6);
+        uint32_t used = get32(payload+10);
+
+        char name[rft::Footprint::NAME_SIZE+1] = {};
+        memcpy(name, payload+14, size-14);
+
+        if (capacity > 0) {
+            printf("%-20s %8u %8u %8u %8u\n", name, bytes, capacity, used,
+                    capacity - used);
+            unused += capacity - used;
+        }
+        else {
+            printf("%-20s %8u %8s %8u\n", name, bytes, "", used);
+        }
+
+        total += bytes;
+    }
+
+    printf("%-20s %8u %8s %8s %8u\n\n", "total", total, "", "", unused);
+
+    if (argc > 1) {
+        FILE * fp = fopen(argv[1], "wb");
+        fwrite(board.tx, 1, board.txCount, fp);
+        fclose(fp);
+    }
+
+    static rft::Footprint * footprint = &firmware.footprint();
+
+    bench::report("Footprint::sampleStack", bench::best([](uint32_t k) {
+                (void)k;
+                footprint->sampleStack();
+                }));
+
+    return count == footprint->count() ? 0 : 1;
+}
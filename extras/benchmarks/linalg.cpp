@@ -0,0 +1,228 @@
+/*
+   Microbenchmarks for RFT_linalg.hpp and the Filter frame conversions
+
+   Before timing, checks that the frame conversions match the scalar code
+   they replaced over a sweep of angles, and that every solve leaves a small
+   residual; exits with status 1 if either check fails.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include <math.h>
+
+#include "RFT_filters.hpp"
+#include "RFT_attitude.hpp"
+#include "bench.hpp"
+
+// Frame conversion as implemented before RFT_linalg.hpp, for comparison
+static void legacyInertial2body(float inertial[3], const float rotation[3],
+                                float body[3])
+{
+    float phi = rotation[0];
+    float theta = rotation[1];
+    float psi = rotation[2];
+
+    float cph = cos(phi);
+    float sph = sin(phi);
+    float cth = cos(theta);
+    float sth = sin(theta);
+    float cps = cos(psi);
+    float sps = sin(psi);
+
+    float R[3][3] = { {cps * cth,                cth * sps,                   -sth},
+        {cps * sph * sth - cph * sps,  cph * cps + sph * sps * sth,  cth * sph},
+        {sph * sps + cph * cps * sth,  cph * sps * sth - cps * sph,  cph * cth} };
+
+    for (uint8_t j = 0; j < 3; ++j) {
+        body[j] = 0;
+        for (uint8_t k = 0; k < 3; ++k) {
+            body[j] += R[j][k] * inertial[k];
+        }
+    }
+}
+
+static void legacyBody2inertial(float body[3], const float rotation[3],
+                                float inertial[3])
+{
+    float phi = rotation[0];
+    float theta = rotation[1];
+    float psi = rotation[2];
+
+    float cph = cos(phi);
+    float sph = sin(phi);
+    float cth = cos(theta);
+    float sth = sin(theta);
+    float cps = cos(psi);
+    float sps = sin(psi);
+
+    float R[3][3] = { {cps * cth,  cps * sph * sth - cph * sps,  sph * sps + cph * cps * sth},
+        {cth * sps,  cph * cps + sph * sps * sth,  cph * sps * sth - cps * sph},
+        {-sth,     cth * sph,                cph * cth} };
+
+    for (uint8_t j = 0; j < 3; ++j) {
+        inertial[j] = 0;
+        for (uint8_t k = 0; k < 3; ++k) {
+            inertial[j] += R[j][k] * body[k];
+        }
+    }
+}
+
+// Largest difference from the legacy conversions over a grid of angles
+// covering every quadrant, for a few vectors
+static float conversionError(void)
+{
+    static const float VECTORS[3][3] = { {1, 2, 3}, {-0.5f, 0, 9.81f},
+        {100, -40, 0.01f} };
+
+    float worst = 0;
+
+    for (int8_t i=-8; i<=8; ++i) {
+        for (int8_t j=-8; j<=8; ++j) {
+            for (int8_t k=-8; k<=8; ++k) {
+
+                const float r[3] = {0.4f*i, 0.2f*j, 0.4f*k};
+
+                for (uint8_t n=0; n<3; ++n) {
+
+                    float v[3] = {VECTORS[n][0], VECTORS[n][1],
+                        VECTORS[n][2]};
+                    float scale = fabsf(v[0]) + fabsf(v[1]) + fabsf(v[2]);
+
+                    float a[3] = {}, b[3] = {}, c[3] = {}, d[3] = {};
+                    legacyInertial2body(v, r, a);
+                    rft::Filter::inertial2body(v, r, b);
+                    legacyBody2inertial(v, r, c);
+                    rft::Filter::body2inertial(v, r, d);
+
+                    for (uint8_t m=0; m<3; ++m) {
+                        worst = fmaxf(worst, fabsf(a[m] - b[m]) / scale);
+                        worst = fmaxf(worst, fabsf(c[m] - d[m]) / scale);
+                    }
+                }
+            }
+        }
+    }
+
+    return worst;
+}
+
+// All of a result goes to the sink, so that none of it is optimized away
+template <uint8_t N>
+static float sum(const rft::Vec<N> & v)
+{
+    float s = 0;
+    for (uint8_t j=0; j<N; ++j) {
+        s += v[j];
+    }
+    return s;
+}
+
+template <uint8_t N>
+static void matvec(void)
+{
+    static rft::Mat<N,N> A;
+    static rft::Vec<N> x;
+    for (uint8_t j=0; j<N; ++j) {
+        x[j] = j + 1;
+        for (uint8_t k=0; k<N; ++k) {
+            A(j,k) = 1.0f / (j + k + 1);
+        }
+    }
+
+    char name[100];
+    snprintf(name, sizeof(name), "Mat<%d,%d> * Vec<%d>", N, N, N);
+    bench::report(name, bench::time([](uint32_t k) {
+                x[0] = k;
+                bench::sink = sum(A * x);
+                }));
+}
+
+// Returns false if the solution's residual is too large
+template <uint8_t N>
+static bool solve(void)
+{
+    // Diagonally dominant, hence positive definite
+    static rft::SymMat<N> A;
+    for (uint8_t j=0; j<N; ++j) {
+        for (uint8_t k=0; k<=j; ++k) {
+            A(j,k) = j == k ? N + 1 : 1.0f / (j + k + 1);
+        }
+    }
+
+    // Check the whole residual before timing
+    rft::SymMat<N> F = A;
+    rft::Vec<N> rhs = rft::Vec<N>::zeros();
+    for (uint8_t j=0; j<N; ++j) {
+        rhs[j] = j & 1 ? -1.0f - j : 1.0f + 0.5f * j;
+    }
+    rft::Vec<N> x = rhs;
+    bool ok = F.solve(x);
+    rft::Vec<N> Ax = A * x;
+    for (uint8_t j=0; ok && j<N; ++j) {
+        ok = fabsf(Ax[j] - rhs[j]) <= 1e-5f * (1 + fabsf(rhs[j]));
+    }
+    if (!ok) {
+        printf("SymMat<%d>::solve() failed\n", N);
+    }
+
+    char name[100];
+    snprintf(name, sizeof(name), "SymMat<%d>::solve", N);
+    bench::report(name, bench::time([](uint32_t k) {
+                rft::SymMat<N> F = A;
+                rft::Vec<N> b = rft::Vec<N>::zeros();
+                b[0] = k;
+                F.solve(b);
+                bench::sink = sum(b);
+                }));
+
+    return ok;
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    static float v[3] = {1, 2, 3};
+
+    float error = conversionError();
+    bool ok = error < 1e-5f;
+    printf("frame conversions vs legacy: worst relative error %.2g%s\n\n",
+            error, ok ? "" : "  FAILED");
+
+    bench::report("legacy inertial2body", bench::time([](uint32_t k) {
+                float r[3] = {1e-3f*(k&1023), 0.2f, 0.3f};
+                float b[3] = {};
+                legacyInertial2body(v, r, b);
+                bench::sink = b[0] + b[1] + b[2];
+                }));
+
+    bench::report("Filter::inertial2body", bench::time([](uint32_t k) {
+                float r[3] = {1e-3f*(k&1023), 0.2f, 0.3f};
+                float b[3] = {};
+                rft::Filter::inertial2body(v, r, b);
+                bench::sink = b[0] + b[1] + b[2];
+                }));
+
+    bench::report("Attitude update + inertial2body",
+            bench::time([](uint32_t k) {
+                rft::Attitude a;
+                a.update(0.8f, 1e-4f*(k&1023), 0.4f, 0.2f);
+                rft::Vec<3> x = { {v[0], v[1], v[2]} };
+                bench::sink = sum(a.inertial2body(x));
+                }));
+
+    matvec<3>();
+    matvec<4>();
+    matvec<6>();
+    matvec<9>();
+
+    ok &= solve<3>();
+    ok &= solve<4>();
+    ok &= solve<6>();
+    ok &= solve<9>();
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+/*
+   Cost of a deferred RFT_LOG() record versus Debugger::printf(), whose
+   output here goes nowhere, so only the formatting is counted
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include "RFT_logger.hpp"
+#include "RFT_debugger.hpp"
+#include "bench.hpp"
+
+void rft::Debugger::outbuf(char * buf)
+{
+    bench::sink = buf[0];
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    static uint8_t frame[120];
+
+    bench::report("Debugger::printf, three floats", bench::time([](uint32_t k) {
+                rft::Debugger::printf("roll %f pitch %f yaw %f\n",
+                        1e-3f*k, 0.2f, 0.3f);
+                }));
+
+    bench::report("Debugger::printfloat x3", bench::time([](uint32_t k) {
+                rft::Debugger::printfloat(1e-3f*k);
+                rft::Debugger::printfloat(0.2f);
+                rft::Debugger::printlnfloat(0.3f);
+                }));
+
+    // Drain as SerialTask would, so that records are not dropped
+    bench::report("RFT_LOG, three floats", bench::time([](uint32_t k) {
+                RFT_LOG("roll %f pitch %f yaw %f", 1e-3f*k, 0.2f, 0.3f);
+                if ((k & 3) == 3) {
+                    bench::sink = rft::Logger::drain(frame, sizeof(frame));
+                }
+                }));
+
+    bench::report("RFT_LOG, one int", bench::time([](uint32_t k) {
+                RFT_LOG("tick %d", k);
+                if ((k & 7) == 7) {
+                    bench::sink = rft::Logger::drain(frame, sizeof(frame));
+                }
+                }));
+
+    printf("%u records dropped\n", (unsigned)rft::Logger::dropped());
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+'''
+Time to open a long state log and seek into it, as text and as a
+memory-mapped state log (see extras/visualizer/statelog.py)
+
+Writes a synthetic four-hour log at 100 Hz in both forms, then reports how
+long each takes to reach a row near the end.  Also converts a captured MSP
+stream and checks that the state log returns what was sent.
+
+Copyright (C) 2021 Simon D. Levy
+
+MIT License
+'''
+
+import math
+import os
+import struct
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, '..', 'visualizer'))
+
+import statelog
+
+HOURS = 4
+RATE = 100
+
+
+def _state(k):
+
+    t = k / RATE
+    return (10 * math.sin(t / 60), 10 * math.cos(t / 60), 0.5 * math.sin(t),
+            math.degrees(t / 60) % 360)
+
+
+def _write_text(path, rows):
+
+    with open(path, 'w') as outfile:
+        for k in range(rows):
+            outfile.write('%+3.3f %+3.3f %+3.3f %+3.3f\n' % _state(k))
+
+
+def _seek_text(path, row):
+
+    # What the visualizers did: parse every line up to the one wanted
+    for k, line in enumerate(open(path)):
+        state = tuple(float(s) for s in line.split())
+        if k == row:
+            return state
+
+
+def _seek_log(path, seconds):
+
+    log = statelog.StateLog(path)
+    row = log.row(log.index(seconds))
+    log.close()
+    return row
+
+
+def _frame(msgid, payload):
+
+    body = bytes([len(payload), msgid]) + payload
+    crc = 0
+    for c in body:
+        crc ^= c
+    return b'$M>' + body + bytes([crc])
+
+
+def _check_msp(directory):
+
+    states = [[k + j for j in range(12)] for k in range(100)]
+
+    capture = os.path.join(directory, 'capture.bin')
+    with open(capture, 'wb') as outfile:
+        for state in states:
+            outfile.write(_frame(122, struct.pack('<12f', *state)))
+            outfile.write(b'noise')
+
+    path = os.path.join(directory, 'capture.rftlog')
+    statelog.write(path, statelog.from_msp(capture, 1. / RATE))
+
+    log = statelog.StateLog(path)
+    ok = (len(log) == len(states) and
+          list(log['x']) == [s[0] for s in states] and
+          list(log['psi']) == [s[10] for s in states] and
+          abs(log['heading'][1] - math.degrees(states[1][10])) < 1e-3)
+    log.close()
+
+    return ok
+
+
+def main():
+
+    rows = HOURS * 3600 * RATE
+    target = rows - RATE
+
+    with tempfile.TemporaryDirectory() as directory:
+
+        text = os.path.join(directory, 'state.txt')
+        binary = os.path.join(directory, 'state.rftlog')
+
+        print('Writing %d-hour log, %d rows ...' % (HOURS, rows))
+        _write_text(text, rows)
+
+        start = time.perf_counter()
+        statelog.write(binary, statelog.from_text(text, 1. / RATE))
+        convert = time.perf_counter() - start
+
+        print('text %.1f MB, state log %.1f MB, converted in %.2f s\n' %
+              (os.path.getsize(text) / 1e6, os.path.getsize(binary) / 1e6,
+               convert))
+
+        start = time.perf_counter()
+        expected = _seek_text(text, target)
+        seconds = time.perf_counter() - start
+        print('text:      row %d after %8.1f ms' % (target, seconds * 1e3))
+
+        start = time.perf_counter()
+        row = _seek_log(binary, target / RATE)
+        seconds = time.perf_counter() - start
+        print('state log: row %d after %8.1f ms' % (target, seconds * 1e3))
+
+        ok = all(abs(a - b) < 1e-3 for a, b in zip(row[1:], expected))
+        ok = ok and seconds < 0.5
+
+        ok = ok and _check_msp(directory)
+
+        print('\n' + ('PASS' if ok else 'FAIL'))
+
+        return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,331 @@
+/*
+   ParameterStore on a memory-mapped host file: a save and reload round trip,
+   the fallback to defaults for a corrupted image or a changed layout, the
+   MSP PARAM_SET / PARAM_SAVE / PARAM_GET exchange, and what loading costs as
+   the number of parameters grows
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "rft_boards/realboards/linux_serial.hpp" // LinuxStorage, outbuf()
+#include "RFT_serialtask.hpp"
+#include "bench.hpp"
+
+typedef rft::MspMessage<124, int16_t, int16_t, uint8_t, int32_t, float, float,
+        float> PARAM_VALUE;
+typedef rft::MspMessage<125, int16_t, int32_t, int32_t, uint8_t> PARAM_STORE;
+typedef rft::MspMessage<216, int16_t> PARAM_GET;
+typedef rft::MspMessage<217, int16_t, float> PARAM_SET;
+typedef rft::MspMessage<218, uint8_t> PARAM_SAVE;
+
+static char path[] = "/tmp/rft_paramsXXXXXX";
+
+// A board whose storage is a mapped file and whose serial port is a pair of
+// memory queues
+class HostBoard : public rft::RealBoard {
+
+    public:
+
+        rft::LinuxStorage storage;
+
+        uint8_t rx[1024] = {};
+        uint16_t rxHead = 0;
+        uint16_t rxTail = 0;
+
+        uint8_t tx[1024] = {};
+        uint16_t txCount = 0;
+
+        // Advanced a whole SerialTask period for each exchange
+        float now = 0;
+
+        float getTime(void) override
+        {
+            return now;
+        }
+
+        void send(uint8_t id, const uint8_t * payload, uint8_t size)
+        {
+            uint8_t crc = size ^ id;
+            rx[rxTail++] = '$';
+            rx[rxTail++] = 'M';
+            rx[rxTail++] = '<';
+            rx[rxTail++] = size;
+            rx[rxTail++] = id;
+            for (uint8_t k=0; k<size; ++k) {
+                rx[rxTail++] = payload[k];
+                crc ^= payload[k];
+            }
+            rx[rxTail++] = crc;
+        }
+
+    protected:
+
+        void setLed(bool isOn) override
+        {
+            (void)isOn;
+        }
+
+        uint8_t serialAvailable(bool secondaryPort) override
+        {
+            (void)secondaryPort;
+            return rxTail - rxHead;
+        }
+
+        uint8_t serialRead(bool secondaryPort) override
+        {
+            (void)secondaryPort;
+            return rx[rxHead++];
+        }
+
+        void serialWrite(uint8_t c, bool secondaryPort) override
+        {
+            (void)secondaryPort;
+            tx[txCount++] = c;
+        }
+
+        bool storageRead(void * dst, uint16_t size) override
+        {
+            return storage.read(dst, size);
+        }
+
+        bool storageWrite(const void * src, uint16_t size) override
+        {
+            return storage.write(src, size);
+        }
+};
+
+class HostState : public rft::State {
+
+    public:
+
+        void setArmed(bool isArmed)
+        {
+            armed = isArmed;
+        }
+
+        bool safeToArm(void) override { return true; }
+};
+
+class NullActuator : public rft::Actuator {
+
+    protected:
+
+        void run(float * demands, bool olcInactive) override
+        {
+            (void)demands;
+            (void)olcInactive;
+        }
+};
+
+// What msppg generates for the PARAM_* messages
+class ParamTask : public rft::SerialTask {
+
+    private:
+
+        uint8_t _payload[128] = {};
+
+    public:
+
+        ParamTask(rft::ParameterStore * parameters)
+        {
+            setParameters(parameters);
+        }
+
+        void tick(HostBoard * board, HostState * state)
+        {
+            NullActuator actuator;
+            update(board, &actuator, state);
+        }
+
+    protected:
+
+        void collectPayload(uint8_t index, uint8_t value) override
+        {
+            _payload[index] = value;
+        }
+
+        void dispatchMessage(uint8_t command) override
+        {
+            switch (command) {
+
+                case PARAM_GET::ID:
+                    {
+                        int16_t index = 0;
+                        PARAM_GET::deserialize(_payload, index);
+                        sendParameter<PARAM_VALUE>(index);
+                    } break;
+
+                case PARAM_SET::ID:
+                    {
+                        int16_t index = 0;
+                        float value = 0;
+                        PARAM_SET::deserialize(_payload, index, value);
+                        setParameter<PARAM_VALUE>(index, value);
+                    } break;
+
+                case PARAM_SAVE::ID:
+                    {
+                        uint8_t reload = 0;
+                        PARAM_SAVE::deserialize(_payload, reload);
+                        saveParameters<PARAM_STORE>(reload);
+                    } break;
+            }
+        }
+};
+
+static const char * NAMES[rft::ParameterStore::MAX] = {};
+
+// The first count of the same parameters; a different tag renames the last
+static void fill(rft::ParameterStore & store, uint8_t count, bool renamed=false)
+{
+    for (uint8_t k=0; k<count; ++k) {
+        if (k & 1) {
+            store.addInt(renamed && k == count-1 ? "renamed" : NAMES[k],
+                    k, -1000, 1000);
+        }
+        else {
+            store.addFloat(renamed && k == count-1 ? "renamed" : NAMES[k],
+                    0.1f * k, -100, 100);
+        }
+    }
+}
+
+static HostBoard board;
+
+// Runs one serial tick and returns the payload of the reply
+static const uint8_t * exchange(ParamTask & task, HostState & state,
+        uint8_t id, const uint8_t * payload, uint8_t size)
+{
+    board.send(id, payload, size);
+    board.txCount = 0;
+    board.now += 1;
+    task.tick(&board, &state);
+    return &board.tx[5];
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    close(mkstemp(path));
+
+    if (!board.storage.open(path)) {
+        fprintf(stderr, "Can't map %s\n", path);
+        return 1;
+    }
+
+    static char names[rft::ParameterStore::MAX][16];
+    for (uint8_t k=0; k<rft::ParameterStore::MAX; ++k) {
+        snprintf(names[k], sizeof(names[k]), "param.%u", k);
+        NAMES[k] = names[k];
+    }
+
+    static const uint8_t MAX = rft::ParameterStore::MAX;
+
+    // Nothing stored yet
+    rft::ParameterStore first;
+    fill(first, MAX);
+    bool loaded = first.begin(&board);
+    printf("fresh file: %s\n", loaded ? "stored values" : "defaults");
+
+    // MSP: set, save while armed, save disarmed, read back
+    {
+        ParamTask task(&first);
+        HostState state;
+
+        uint8_t set[PARAM_SET::PAYLOAD_SIZE];
+        PARAM_SET::serialize(set, 2, 250.f);  // range is -100..100
+        const uint8_t * reply = exchange(task, state, PARAM_SET::ID, set,
+                sizeof(set));
+
+        int16_t index = 0, count = 0;
+        uint8_t type = 0;
+        int32_t name = 0;
+        float value = 0, minimum = 0, maximum = 0;
+        PARAM_VALUE::deserialize(reply, index, count, type, name, value,
+                minimum, maximum);
+        printf("PARAM_SET 2 = 250:  value %g (clamped to %g..%g), name "
+                "hash %s\n", value, minimum, maximum,
+                (uint32_t)name == first.nameHash(2) ? "matches" : "WRONG");
+
+        PARAM_SET::serialize(set, 3, -7.4f);
+        exchange(task, state, PARAM_SET::ID, set, sizeof(set));
+
+        uint8_t save[PARAM_SAVE::PAYLOAD_SIZE];
+        PARAM_SAVE::serialize(save, 0);
+
+        int16_t stored = 0;
+        int32_t layout = 0, checksum = 0;
+        uint8_t ok = 0;
+
+        state.setArmed(true);
+        reply = exchange(task, state, PARAM_SAVE::ID, save, sizeof(save));
+        PARAM_STORE::deserialize(reply, stored, layout, checksum, ok);
+        printf("PARAM_SAVE armed:    ok=%u\n", ok);
+
+        state.setArmed(false);
+        reply = exchange(task, state, PARAM_SAVE::ID, save, sizeof(save));
+        PARAM_STORE::deserialize(reply, stored, layout, checksum, ok);
+        printf("PARAM_SAVE disarmed: ok=%u, %d parameters\n", ok, stored);
+
+        uint8_t get[PARAM_GET::PAYLOAD_SIZE];
+        PARAM_GET::serialize(get, MAX);
+        reply = exchange(task, state, PARAM_GET::ID, get, sizeof(get));
+        PARAM_VALUE::deserialize(reply, index, count, type, name, value,
+                minimum, maximum);
+        printf("PARAM_GET %u:        index %d (out of range)\n\n", MAX, index);
+    }
+
+    // As after a reboot
+    rft::ParameterStore second;
+    fill(second, MAX);
+    loaded = second.begin(&board);
+    printf("reloaded: %-18s param 2 = %g, param 3 = %d\n",
+            loaded ? "stored values," : "DEFAULTS,",
+            second.getFloat(2), second.getInt(3));
+
+    // A changed parameter name
+    rft::ParameterStore renamed;
+    fill(renamed, MAX, true);
+    loaded = renamed.begin(&board);
+    printf("renamed:  %-18s param 2 = %g\n",
+            loaded ? "STORED VALUES," : "defaults,", renamed.getFloat(2));
+
+    // A flipped bit in the stored values
+    uint8_t image[rft::LinuxStorage::SIZE];
+    board.storage.read(image, sizeof(image));
+    image[30] ^= 0x10;
+    board.storage.write(image, sizeof(image));
+    rft::ParameterStore corrupted;
+    fill(corrupted, MAX);
+    loaded = corrupted.begin(&board);
+    printf("corrupted: %-17s param 2 = %g\n\n",
+            loaded ? "STORED VALUES," : "defaults,", corrupted.getFloat(2));
+
+    // Loading cost, with the image stored for each size first
+    for (uint8_t count=4; count<=MAX; count*=2) {
+
+        static rft::ParameterStore store;
+        store = rft::ParameterStore();
+        fill(store, count);
+        store.begin(&board);
+        store.save();
+
+        char name[64];
+        snprintf(name, sizeof(name), "load, %2u parameters", count);
+        bench::report(name, bench::best([](uint32_t k) {
+                    (void)k;
+                    bench::sink = store.load();
+                    }));
+    }
+
+    unlink(path);
+
+    return 0;
+}
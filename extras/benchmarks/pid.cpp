@@ -0,0 +1,76 @@
+/*
+   Per-tick cost of Pid::compute() versus a typical hand-rolled PID that
+   handles dt, divides and clamps inside the loop
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include "rft_closedloops/pidcontroller.hpp"
+#include "bench.hpp"
+
+class NaivePid {
+
+    private:
+
+        float _kp, _ki, _kd;
+        float _integral = 0;
+        float _lastError = 0;
+        float _lastTime = 0;
+
+    public:
+
+        NaivePid(float kp, float ki, float kd)
+            : _kp(kp), _ki(ki), _kd(kd)
+        {
+        }
+
+        float compute(float target, float measurement, float time)
+        {
+            float dt = time - _lastTime;
+            _lastTime = time;
+
+            float error = target - measurement;
+
+            _integral = rft::Filter::constrainAbs(_integral + error * dt, 1);
+
+            float derivative = dt > 0 ? (error - _lastError) / dt : 0;
+            _lastError = error;
+
+            return rft::Filter::constrainAbs(
+                    _kp * error + _ki * _integral + _kd * derivative, 1);
+        }
+};
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    static NaivePid naive(0.5, 0.1, 0.01);
+
+    static rft::Pid pid(0.5, 0.1, 0.01);
+
+    static rft::PidSchedule<4> schedule;
+    schedule.add(0.0, 0.6, 0.1, 0.02);
+    schedule.add(0.3, 0.5, 0.1, 0.01);
+    schedule.add(0.7, 0.4, 0.1, 0.01);
+    schedule.add(1.0, 0.3, 0.1, 0.01);
+
+    bench::report("naive PID", bench::time([](uint32_t k) {
+                bench::sink = naive.compute(0.1f, 1e-4f*(k&1023), k/300.f);
+                }));
+
+    bench::report("Pid::compute", bench::time([](uint32_t k) {
+                bench::sink = pid.compute(0.1f, 1e-4f*(k&1023));
+                }));
+
+    bench::report("PidSchedule::apply + Pid::compute",
+            bench::time([](uint32_t k) {
+                schedule.apply(1e-3f*(k&1023), pid);
+                bench::sink = pid.compute(0.1f, 1e-4f*(k&1023));
+                }));
+
+    return 0;
+}
@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+'''
+Throughput of the Python MSP parser generated by msppg.py
+
+Generates mspparser.py from messages.json, then decodes a captured-style
+stream of STATE messages with the generated bulk parser, fed in large chunks
+and a byte at a time, and with the byte-at-a-time state machine that msppg.py
+used to emit.
+
+Copyright (C) 2021 Simon D. Levy
+
+MIT License
+'''
+
+import contextlib
+import io
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+MESSAGES = 20000
+CHUNK = 4096
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+PARSER = os.path.join(HERE, '..', 'parser')
+
+
+class _StateMachine(object):
+    '''
+    The per-byte parser msppg.py used to emit, handling STATE only
+    '''
+
+    def __init__(self, handler):
+
+        self.handler = handler
+        self.state = 0
+
+    def parse(self, char):
+
+        byte = ord(char)
+
+        if self.state == 0:
+            if byte == 36:
+                self.state += 1
+
+        elif self.state == 1:
+            if byte == 77:
+                self.state += 1
+            else:
+                self.state = 0
+
+        elif self.state == 2:
+            self.state += 1
+
+        elif self.state == 3:
+            self.message_length_expected = byte
+            self.message_checksum = byte
+            self.message_buffer = b''
+            self.state += 1
+
+        elif self.state == 4:
+            self.message_id = byte
+            self.message_length_received = 0
+            self.message_checksum ^= byte
+            self.state += 1 if self.message_length_expected > 0 else 2
+
+        elif self.state == 5:
+            self.message_buffer += char
+            self.message_checksum ^= byte
+            self.message_length_received += 1
+            if self.message_length_received >= self.message_length_expected:
+                self.state += 1
+
+        elif self.state == 6:
+            if self.message_checksum == byte and self.message_id == 122:
+                self.handler(*struct.unpack('=ffffffffffff',
+                                            self.message_buffer))
+            self.state = 0
+
+
+def _generate(directory):
+
+    subprocess.check_call([sys.executable,
+                           os.path.join(PARSER, 'msppg.py'),
+                           '--infile', os.path.join(PARSER, 'messages.json'),
+                           '--language', 'python'],
+                          cwd=directory, stdout=subprocess.DEVNULL)
+
+    sys.path.insert(0, directory)
+
+    import mspparser
+
+    return mspparser.MspParser
+
+
+def _frame(msgid, payload):
+
+    body = bytes([len(payload), msgid]) + payload
+    crc = 0
+    for c in body:
+        crc ^= c
+    return b'$M>' + body + bytes([crc])
+
+
+def _stream(count):
+
+    random.seed(0)
+
+    frames = []
+
+    for k in range(count):
+        state = [random.uniform(-10, 10) for _ in range(12)]
+        frames.append(_frame(122, struct.pack('<12f', *state)))
+        # The odd unrelated message in between
+        if k % 10 == 0:
+            frames.append(_frame(123, bytes([1])))
+
+    return b''.join(frames)
+
+
+def _make(base, callback=None):
+
+    class Counter(base):
+
+        def __init__(self):
+            base.__init__(self)
+            self.count = 0
+            self.last = None
+            self.callback = callback
+
+        def handle_RECEIVER(self, *args):
+            return
+
+        def handle_STATE(self, *args):
+            self.count += 1
+            self.last = args
+            if self.callback is not None:
+                self.callback(*args)
+
+        def handle_ACTUATOR_TYPE(self, *args):
+            return
+
+        def handle_PARAM_VALUE(self, *args):
+            return
+
+        def handle_PARAM_STORE(self, *args):
+            return
+
+    return Counter()
+
+
+def _time(parse, chunks):
+
+    start = time.perf_counter()
+    for chunk in chunks:
+        parse(chunk)
+    return time.perf_counter() - start
+
+
+def _report(name, seconds, nbytes, count):
+
+    print('%-28s %8.2f MB/s %10.0f msg/s' %
+          (name, nbytes / seconds / 1e6, count / seconds))
+
+
+def main():
+
+    with tempfile.TemporaryDirectory() as directory:
+
+        base = _generate(directory)
+
+        data = _stream(MESSAGES)
+        chunks = [data[k:k+CHUNK] for k in range(0, len(data), CHUNK)]
+        singles = [data[k:k+1] for k in range(len(data))]
+
+        print('%d STATE messages, %d bytes\n' % (MESSAGES, len(data)))
+
+        bulk = _make(base)
+        seconds = _time(bulk.parse, chunks)
+        _report('bulk, %d-byte chunks' % CHUNK, seconds, len(data), bulk.count)
+
+        single = _make(base)
+        seconds = _time(single.parse, singles)
+        _report('bulk, one byte at a time', seconds, len(data), single.count)
+
+        reference = []
+        machine = _StateMachine(lambda *args: reference.append(args))
+        seconds = _time(machine.parse, singles)
+        _report('old per-byte state machine', seconds, len(data),
+                len(reference))
+
+        ok = (bulk.count == MESSAGES and single.count == MESSAGES and
+              len(reference) == MESSAGES and bulk.last == reference[-1])
+
+        # Corrupt some bytes: every message the old parser accepts should
+        # still come through, in order.  (An XOR checksum misses two flips
+        # of the same bit, so both parsers pass the odd damaged message.)
+        sent = []
+        _make(base, lambda *args: sent.append(args)).parse(data)
+
+        random.seed(1)
+        damaged = bytearray(data)
+        for _ in range(200):
+            damaged[random.randrange(len(damaged))] ^= 0x55
+
+        reference = []
+        machine = _StateMachine(lambda *args: reference.append(args))
+        for k in range(len(damaged)):
+            machine.parse(damaged[k:k+1])
+
+        decoded = []
+        checked = _make(base, lambda *args: decoded.append(args))
+        with contextlib.redirect_stdout(io.StringIO()):
+            for k in range(0, len(damaged), 1000):
+                checked.parse(bytes(damaged[k:k+1000]))
+
+        # The old parser's messages, in order, with any others in between:
+        # after a bad checksum the old parser skipped the damaged frame's
+        # claimed length, losing frames that the new one finds by
+        # resynchronizing on the next $M, so those extras must all be
+        # messages that were sent intact
+        matched = 0
+        extra = []
+        for args in decoded:
+            if matched < len(reference) and args == reference[matched]:
+                matched += 1
+            else:
+                extra.append(args)
+
+        intact = set(sent)
+        recovered = sum(args in intact for args in extra)
+
+        print('\ncorrupted stream: %d messages decoded, %d by old parser, '
+              '%d checksum failures' %
+              (len(decoded), len(reference), checked.crc_errors))
+        print('%d of the old parser\'s found in order, %d more recovered by '
+              'resynchronizing, %d of them sent intact' %
+              (matched, len(extra), recovered))
+
+        ok = (ok and matched == len(reference) and
+              recovered == len(extra))
+
+        print('\n' + ('PASS' if ok else 'FAIL'))
+
+        return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,254 @@
+/*
+   End-to-end closed-loop flight against the simulated quadrotor: take off,
+   hold 2 m, then report the hover error and how much faster than real time
+   the simulation ran.  Flies twice: reading the gyro once per poll, and as
+   an 8 kHz gyro decimated to 500 Hz before the quaternion filter.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include <math.h>
+
+#include "RFT_pure.hpp"
+#include "RFT_attitude.hpp"
+#include "rft_boards/simboard.hpp"
+#include "rft_closedloops/pidcontroller.hpp"
+#include "rft_estimators/altitude.hpp"
+#include "rft_sitl/actuator.hpp"
+#include "rft_sitl/sensors.hpp"
+#include "bench.hpp"
+
+static const float DT = 0.0005; // 2 kHz physics
+
+static const float TARGET_ALTITUDE = 2;
+
+// MPU-6000 at 2000 deg/s full scale
+static const float GYRO_LSB = 1 / 16.4f * M_PI / 180;
+
+// Gyro samples per poll: 8 kHz
+static const uint8_t OVERSAMPLING = 4;
+
+class QuadState : public rft::State {
+
+    public:
+
+        float euler[3] = {};      // phi, theta, psi
+        float rates[3] = {};      // body rates
+        float altitude = 0;
+
+        QuadState(void) : State(true) { }
+
+        bool safeToArm(void) override { return true; }
+};
+
+class Imu : public rft::SimImu {
+
+    private:
+
+        rft::MadgwickQuaternionFilter6DOF _madgwick;
+        rft::Attitude _attitude;
+        rft::AltitudeEstimator _altitude;
+        rft::Decimator<3> _decimator = rft::Decimator<3>(GYRO_LSB);
+        bool _decimate = false;
+        float _time = 0;
+
+    public:
+
+        float baro = 0;
+        bool haveBaro = false;
+
+        Imu(rft::QuadPlant * plant, bool decimate)
+            : SimImu(plant), _madgwick(0.1, 0.0), _decimate(decimate) { }
+
+        void modifyState(rft::State * state, float time) override
+        {
+            QuadState * s = (QuadState *)state;
+
+            float g[3], a[3];
+
+            if (_decimate) {
+                if (!readGyrometer(_decimator, OVERSAMPLING, g)) {
+                    return;
+                }
+            }
+            else {
+                readGyrometer(g[0], g[1], g[2]);
+            }
+
+            float dt = time - _time;
+            _time = time;
+            if (dt <= 0) {
+                return;
+            }
+
+            readAccelerometer(a[0], a[1], a[2]);
+
+            // Madgwick wants the direction of gravity, opposite the specific
+            // force
+            _madgwick.update(-a[0], -a[1], -a[2], g[0], g[1], g[2], dt);
+
+            _attitude.update(_madgwick);
+
+            // Filter::quat2euler() reports pitch nose-down
+            const float * e = _attitude.euler();
+            s->euler[0] = e[0];
+            s->euler[1] = -e[1];
+            s->euler[2] = e[2];
+
+            s->rates[0] = g[0];
+            s->rates[1] = g[1];
+            s->rates[2] = g[2];
+
+            // Vertical specific force in NED, plus gravity, negated for up
+            rft::Vec<3> fb = { {a[0], a[1], a[2]} };
+            float up = -(_attitude.body2inertial(fb)[2] + rft::QuadPlant::G);
+
+            _altitude.predict(dt, up);
+            if (haveBaro) {
+                _altitude.updateBaro(baro);
+                haveBaro = false;
+            }
+
+            s->altitude = _altitude.altitude();
+        }
+};
+
+class Baro : public rft::SimBaro {
+
+    private:
+
+        Imu * _imu;
+        uint32_t _count = 0;
+
+    public:
+
+        Baro(rft::QuadPlant * plant, Imu * imu)
+            : SimBaro(plant), _imu(imu) { }
+
+        // 50 Hz
+        void modifyState(rft::State * state, float time) override
+        {
+            (void)state;
+            (void)time;
+
+            if (++_count % 40 == 0) {
+                _imu->baro = readAltitude();
+                _imu->haveBaro = true;
+            }
+        }
+};
+
+class Receiver : public rft::OpenLoopController {
+
+    public:
+
+        // Throttle demand is the target altitude; the rest are level
+        void getDemands(float * demands) override
+        {
+            demands[0] = TARGET_ALTITUDE;
+        }
+};
+
+class HoverController : public rft::ClosedLoopController {
+
+    private:
+
+        static constexpr float RATE = 285; // ClosedLoopTask on a 2 kHz clock
+
+        rft::Pid _altitude = rft::Pid(0.15, 0.05, 0.1, RATE, 10, 0.3, 0.5);
+        rft::Pid _roll = rft::Pid(0.3, 0.0, 0.05, RATE, 40, 0.1, 0.3);
+        rft::Pid _pitch = rft::Pid(0.3, 0.0, 0.05, RATE, 40, 0.1, 0.3);
+        rft::Pid _yaw = rft::Pid(0.1, 0.0, 0.0, RATE, 40, 0.1, 0.3);
+
+        float _hover = 0;
+
+    public:
+
+        HoverController(float hover) : _hover(hover) { }
+
+        void modifyDemands(rft::State * state, float * demands) override
+        {
+            QuadState * s = (QuadState *)state;
+
+            demands[0] = _hover + _altitude.compute(demands[0], s->altitude);
+            demands[1] = _roll.compute(demands[1], s->euler[0]);
+            demands[2] = _pitch.compute(demands[2], s->euler[1]);
+            demands[3] = _yaw.compute(demands[3], s->rates[2]);
+        }
+};
+
+class Firmware : public rft::RFTPure {
+
+    public:
+
+        Firmware(rft::Board * b, rft::OpenLoopController * r,
+                 rft::Actuator * a)
+            : RFTPure(b, r, a) { }
+
+        void begin(void) { RFTPure::begin(); }
+
+        void update(QuadState * state) { RFTPure::update(state); }
+};
+
+static void fly(const char * label, bool decimate)
+{
+    rft::QuadPlant plant;
+    rft::SimBoard board(DT);
+    Receiver receiver;
+    rft::SimQuadActuator actuator(&plant);
+    Imu imu(&plant, decimate);
+    Baro baro(&plant, &imu);
+    QuadState state;
+
+    // Throttle giving thrust equal to weight
+    rft::QuadPlant::Params p;
+    HoverController hover(sqrtf(p.mass * rft::QuadPlant::G / (4*p.maxThrust)));
+
+    Firmware firmware(&board, &receiver, &actuator);
+    firmware.addSensor(&imu);
+    firmware.addSensor(&baro);
+    firmware.addClosedLoopController(&hover);
+    firmware.begin();
+
+    static const uint32_t STEPS = 20 / DT;
+    float err2 = 0;
+    uint32_t n = 0;
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    for (uint32_t k=0; k<STEPS; ++k) {
+
+        board.step();
+        firmware.update(&state);
+        plant.step(DT);
+
+        // Score the last half of the flight
+        if (k > STEPS/2) {
+            float e = plant.altitude() - TARGET_ALTITUDE;
+            err2 += e * e;
+            n++;
+        }
+    }
+
+    double sec = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+    printf("%-10s hover RMS altitude error %.3f m, final attitude "
+           "%+.3f %+.3f %+.3f rad, %.0fx real time\n", label,
+           sqrt(err2/n), state.euler[0], state.euler[1], state.euler[2],
+           STEPS * DT / sec);
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    fly("direct", false);
+    fly("decimated", true);
+
+    return 0;
+}
@@ -0,0 +1,527 @@
+/*
+   Regression suite: times every routine in RFT_filters.hpp, Parser::parse()
+   and the serialize paths, and full ClosedLoopTask ticks, and checks each
+   against baselines.txt, failing if any is slower by more than the threshold
+
+       % make baselines            save this machine's baselines once
+       % ./regress                 check against baselines.txt
+       % ./regress -t 10           ... failing past 10% instead of 25%
+       % ./regress -s              save this run as the new baselines
+       % ./regress -f other.txt    use another baselines file
+
+   Timings are scaled by how fast a fixed reference loop runs compared with
+   when the baselines were saved, which takes out most of the drift of a busy
+   machine; still, baselines depend on the CPU and compiler, so none are
+   shipped: until you save your own, regress only reports the timings.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include <stdlib.h>
+
+#include "RFT_parser.hpp"
+#include "RFT_closedlooptask.hpp"
+#include "rft_closedloops/pidcontroller.hpp"
+#include "bench.hpp"
+
+static const char * REFERENCE = "(reference)";
+
+static bench::Baselines baselines;
+static bool saving = false;
+static double threshold = 0.25;
+
+// Plain arithmetic that no change to the library can affect, timed next to
+// each routine to factor out how fast the machine happens to be running
+static void referenceLoop(uint32_t k);
+
+// Saved timings are scaled to the reference's speed at the start of the run
+static double startReference = 0;
+
+// Fastest of several runs, alternating with the reference; returns the
+// reference's time
+template <typename F>
+static double timeRuns(F fun, uint32_t n, double & ns)
+{
+    double reference = 0;
+
+    for (uint8_t r=0; r<7; ++r) {
+        double t = bench::time(fun, n);
+        ns = r == 0 || t < ns ? t : ns;
+        t = bench::time(referenceLoop);
+        reference = r == 0 || t < reference ? t : reference;
+    }
+
+    return reference;
+}
+
+template <typename F>
+static void measure(const char * name, F fun, uint32_t bytesPerOp=0,
+                    uint32_t n=200000)
+{
+    double ns = 0;
+    double reference = timeRuns(fun, n, ns);
+
+    // A regression has to show up on a second and third try, so that a
+    // burst of activity elsewhere on the machine doesn't fail the run
+    for (uint8_t retry=0; !saving && retry<2; ++retry) {
+
+        baselines.calibrate(REFERENCE, reference);
+
+        if (baselines.change(name, ns) <= threshold) {
+            break;
+        }
+
+        reference = timeRuns(fun, n, ns);
+    }
+
+    bench::report(name, ns);
+
+    if (bytesPerOp > 0) {
+        printf("    %.1f MB/s\n", bytesPerOp * 1e3 / ns);
+    }
+
+    if (saving) {
+        baselines.set(name, ns * startReference / reference);
+    }
+    else {
+        baselines.calibrate(REFERENCE, reference);
+        baselines.check(name, ns, threshold);
+    }
+}
+
+// Sensor readings to feed the filters, varied so that nothing folds away
+static const uint16_t SAMPLES = 1024;
+static float accel[SAMPLES][3];
+static float gyro[SAMPLES][3];
+static float mag[SAMPLES][3];
+static float angles[SAMPLES][3];
+
+static void makeSamples(void)
+{
+    for (uint16_t k=0; k<SAMPLES; ++k) {
+
+        float t = k / (float)SAMPLES;
+
+        for (uint8_t j=0; j<3; ++j) {
+            accel[k][j] = (j == 2 ? 1 : 0) + 0.05f * sinf(7 * t + j);
+            gyro[k][j] = 0.2f * cosf(5 * t + j);
+            mag[k][j] = (j == 0 ? 0.4f : 0.1f) + 0.02f * sinf(3 * t + j);
+            angles[k][j] = 0.5f * sinf(2 * t + j);
+        }
+    }
+}
+
+static void referenceLoop(uint32_t k)
+{
+    float x = angles[k&1023][0];
+    for (uint8_t j=0; j<16; ++j) {
+        x = x * 0.999f + 0.001f;
+    }
+    bench::sink = x;
+}
+
+// Exposes Parser's protected interface
+class MspBench : public rft::Parser {
+
+    public:
+
+        float motors[4] = {};
+
+        void feed(uint8_t c)
+        {
+            parse(c);
+        }
+
+        void sendFloats(const float * values, uint8_t count)
+        {
+            prepareToSendFloats(122, count);
+            for (uint8_t k=0; k<count; ++k) {
+                sendFloat(values[k]);
+            }
+            completeSend();
+        }
+
+        void sendState(const float * v)
+        {
+            sendMessage<rft::MspMessage<122, float, float, float, float,
+                float, float, float, float, float, float, float, float>>(
+                        v[0], v[1], v[2], v[3], v[4], v[5],
+                        v[6], v[7], v[8], v[9], v[10], v[11]);
+        }
+
+        uint8_t drain(void)
+        {
+            uint8_t c = 0;
+            while (availableBytes() > 0) {
+                c ^= readByte();
+            }
+            return c;
+        }
+
+    protected:
+
+        uint8_t _payload[16] = {};
+
+        void collectPayload(uint8_t index, uint8_t value) override
+        {
+            _payload[index & 15] = value;
+        }
+
+        void dispatchMessage(uint8_t type) override
+        {
+            if (type == 215) {
+                memcpy(motors, _payload, sizeof(motors));
+            }
+        }
+};
+
+// Incoming SET_MOTOR messages
+static const uint8_t FRAME = 22;
+static const uint16_t FRAMES = 64;
+static uint8_t stream[FRAME * FRAMES];
+
+static void makeStream(void)
+{
+    for (uint16_t f=0; f<FRAMES; ++f) {
+
+        uint8_t * frame = &stream[f * FRAME];
+
+        frame[0] = '$';
+        frame[1] = 'M';
+        frame[2] = '<';
+        frame[3] = 16;
+        frame[4] = 215;
+
+        for (uint8_t k=0; k<4; ++k) {
+            float value = (f + k) / 100.f;
+            memcpy(&frame[5 + 4*k], &value, 4);
+        }
+
+        uint8_t crc = 0;
+        for (uint8_t k=3; k<21; ++k) {
+            crc ^= frame[k];
+        }
+        frame[21] = crc;
+    }
+}
+
+class TickBoard : public rft::Board {
+
+    public:
+
+        float time = 0;
+
+        // Always past the task's period
+        float getTime(void) override { return time += 1; }
+};
+
+class SticksReceiver : public rft::OpenLoopController {
+
+    public:
+
+        uint32_t k = 0;
+
+        void getDemands(float * demands) override
+        {
+            k++;
+            for (uint8_t j=0; j<4; ++j) {
+                demands[j] = angles[(k + j) & (SAMPLES-1)][j % 3];
+            }
+        }
+};
+
+// In the lowest of three modes, as with the aux switch down
+class ModeReceiver : public SticksReceiver {
+
+    public:
+
+        uint8_t getModeIndex(void) override
+        {
+            return 0;
+        }
+};
+
+class TickState : public rft::State {
+
+    public:
+
+        uint32_t k = 0;
+
+        TickState(void) : State(true) { }
+
+        bool safeToArm(void) override { return true; }
+};
+
+class SinkActuator : public rft::Actuator {
+
+    public:
+
+        void run(float * demands, bool olcInactive) override
+        {
+            (void)olcInactive;
+            bench::sink = demands[0] + demands[1] + demands[2] + demands[3];
+        }
+};
+
+class AxisPid : public rft::PidController {
+
+    private:
+
+        uint8_t _axis = 0;
+
+    public:
+
+        AxisPid(uint8_t axis)
+            : PidController(axis, rft::Pid(0.5, 0.1, 0.01)), _axis(axis) { }
+
+        float getMeasurement(rft::State * state) override
+        {
+            TickState * s = (TickState *)state;
+            return gyro[s->k++ & (SAMPLES-1)][_axis % 3];
+        }
+};
+
+class BenchTask : public rft::ClosedLoopTask {
+
+    public:
+
+        BenchTask(void) : ClosedLoopTask(300) { }
+
+        void add(rft::ClosedLoopController * controller, uint8_t mode)
+        {
+            addController(controller, mode);
+        }
+
+        void tick(rft::Board * board, rft::OpenLoopController * olc,
+                  rft::Actuator * actuator, rft::State * state)
+        {
+            update(board, olc, actuator, state);
+        }
+};
+
+int main(int argc, char ** argv)
+{
+    const char * path = "baselines.txt";
+
+    for (int k=1; k<argc; ++k) {
+        if (!strcmp(argv[k], "-s")) {
+            saving = true;
+        }
+        else if (!strcmp(argv[k], "-t") && k+1 < argc) {
+            threshold = atof(argv[++k]) / 100;
+        }
+        else if (!strcmp(argv[k], "-f") && k+1 < argc) {
+            path = argv[++k];
+        }
+        else {
+            fprintf(stderr, "usage: %s [-s] [-t percent] [-f baselines]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    bool checking = !saving && baselines.load(path);
+
+    if (!checking && !saving) {
+        printf("no baselines in %s; reporting only (make baselines to save "
+               "this machine's)\n\n", path);
+    }
+
+    makeSamples();
+    makeStream();
+
+    // Let the clock settle at full speed before the first timing
+    bench::time([](uint32_t k) {
+            bench::sink = rft::Filter::rad2deg(angles[k&1023][0]);
+            }, 300000000);
+
+    startReference = bench::best(referenceLoop);
+
+    if (saving) {
+        baselines.set(REFERENCE, startReference);
+    }
+    else if (checking) {
+        printf("machine speed x%.2f of baseline\n\n",
+                1 / baselines.calibrate(REFERENCE, startReference));
+    }
+
+    // Filter conversions ---------------------------------------------------
+
+    measure("Filter::complementary", [](uint32_t k) {
+                bench::sink = rft::Filter::complementary(
+                        angles[k&1023][0], angles[k&1023][1], 0.98f);
+                });
+
+    measure("Filter::constrainMinMax", [](uint32_t k) {
+                bench::sink = rft::Filter::constrainMinMax(
+                        angles[k&1023][0], -0.2f, 0.3f);
+                });
+
+    measure("Filter::constrainAbs", [](uint32_t k) {
+                bench::sink = rft::Filter::constrainAbs(angles[k&1023][0], 0.2f);
+                });
+
+    measure("Filter::deg2rad", [](uint32_t k) {
+                bench::sink = rft::Filter::deg2rad(angles[k&1023][0]);
+                });
+
+    measure("Filter::rad2deg", [](uint32_t k) {
+                bench::sink = rft::Filter::rad2deg(angles[k&1023][0]);
+                });
+
+    measure("Filter::euler2quat", [](uint32_t k) {
+                float q[4];
+                rft::Filter::euler2quat(angles[k&1023], q);
+                bench::sink = q[0] + q[3];
+                });
+
+    measure("Filter::quat2euler", [](uint32_t k) {
+                float q[4], ex, ey, ez;
+                rft::Filter::euler2quat(angles[k&1023], q);
+                rft::Filter::quat2euler(q[0], q[1], q[2], q[3], ex, ey, ez);
+                bench::sink = ex + ey + ez;
+                });
+
+    measure("Filter::inertial2body", [](uint32_t k) {
+                float body[3];
+                rft::Filter::inertial2body(accel[k&1023], angles[k&1023], body);
+                bench::sink = body[0] + body[2];
+                });
+
+    measure("Filter::body2inertial", [](uint32_t k) {
+                float inertial[3];
+                rft::Filter::body2inertial(accel[k&1023], angles[k&1023],
+                                           inertial);
+                bench::sink = inertial[0] + inertial[2];
+                });
+
+    // LowPassFilter --------------------------------------------------------
+
+    static rft::LowPassFilter lpf(50);
+    lpf.begin();
+
+    measure("LowPassFilter::update", [](uint32_t k) {
+                bench::sink = lpf.update(gyro[k&1023][0]);
+                });
+
+    measure("LowPassFilter::begin", [](uint32_t k) {
+                (void)k;
+                lpf.begin();
+                });
+
+    // Quaternion filters ---------------------------------------------------
+
+    static rft::MadgwickQuaternionFilter9DOF madgwick9(0.1);
+
+    measure("MadgwickQuaternionFilter9DOF::update",
+            [](uint32_t k) {
+                float * a = accel[k&1023], * g = gyro[k&1023], * m = mag[k&1023];
+                madgwick9.update(a[0], a[1], a[2], g[0], g[1], g[2],
+                                 m[0], m[1], m[2], 0.002f);
+                bench::sink = madgwick9.q1;
+                });
+
+    static rft::MadgwickQuaternionFilter6DOF madgwick6(0.1, 0.01);
+
+    measure("MadgwickQuaternionFilter6DOF::update",
+            [](uint32_t k) {
+                float * a = accel[k&1023], * g = gyro[k&1023];
+                madgwick6.update(a[0], a[1], a[2], g[0], g[1], g[2], 0.002f);
+                bench::sink = madgwick6.q1;
+                });
+
+    static rft::MahonyQuaternionFilter9DOF mahony;
+
+    measure("MahonyQuaternionFilter9DOF::update",
+            [](uint32_t k) {
+                float * a = accel[k&1023], * g = gyro[k&1023], * m = mag[k&1023];
+                mahony.update(a[0], a[1], a[2], g[0], g[1], g[2],
+                              m[0], m[1], m[2], 0.002f);
+                bench::sink = mahony.q1;
+                });
+
+    // MSP ------------------------------------------------------------------
+
+    static MspBench msp;
+
+    measure("Parser::parse (per byte)", [](uint32_t k) {
+                msp.feed(stream[k % sizeof(stream)]);
+                }, 1, 1000000);
+
+    bench::sink = msp.motors[0];
+
+    measure("sendFloat x12 + drain", [](uint32_t k) {
+                msp.sendFloats(angles[k&1023], 12);
+                bench::sink = msp.drain();
+                }, 54);
+
+    measure("sendMessage<STATE> + drain", [](uint32_t k) {
+                msp.sendState(angles[k&1023]);
+                bench::sink = msp.drain();
+                }, 54);
+
+    // ClosedLoopTask -------------------------------------------------------
+
+    static TickBoard board;
+    static SticksReceiver receiver;
+    static TickState state;
+    static SinkActuator actuator;
+    static AxisPid roll(0), pitch(1), yaw(2), level(3);
+    static BenchTask task;
+
+    task.add(&roll, 0);
+    task.add(&pitch, 0);
+    task.add(&yaw, 0);
+    task.add(&level, 1);
+
+    measure("ClosedLoopTask tick (4 PIDs)", [](uint32_t k) {
+                (void)k;
+                task.tick(&board, &receiver, &actuator, &state);
+                });
+
+    // Rate PIDs, then level and altitude hold on the higher modes, which
+    // the tick shouldn't pay for until they're switched in
+    static ModeReceiver switched;
+    static AxisPid rates[3] = {0, 1, 2};
+    static AxisPid levels[2] = {0, 1};
+    static AxisPid holds[2] = {3, 3};
+    static BenchTask modes;
+
+    for (uint8_t k=0; k<3; ++k) {
+        modes.add(&rates[k], 0);
+    }
+    for (uint8_t k=0; k<2; ++k) {
+        modes.add(&levels[k], 1);
+        modes.add(&holds[k], 2);
+    }
+
+    measure("ClosedLoopTask tick (7 PIDs, 3 in mode)", [](uint32_t k) {
+                (void)k;
+                modes.tick(&board, &switched, &actuator, &state);
+                });
+
+    if (saving) {
+
+        if (!baselines.save(path, "ns/op name; written by regress -s")) {
+            fprintf(stderr, "can't write %s\n", path);
+            return 2;
+        }
+
+        printf("\nsaved baselines to %s\n", path);
+
+        return 0;
+    }
+
+    if (!checking) {
+        return 0;
+    }
+
+    uint16_t regressions = baselines.regressions();
+
+    printf("\n%d regression%s past %.0f%%\n", regressions,
+            regressions == 1 ? "" : "s", 100*threshold);
+
+    return regressions > 0 ? 1 : 0;
+}
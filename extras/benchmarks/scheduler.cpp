@@ -0,0 +1,211 @@
+/*
+   Control-task latency under serial and background load, on a simulated
+   clock: the fixed call order of the old update() against the Scheduler
+
+   A 500 Hz control task, two 66 Hz serial tasks with 1.2 ms of work each
+   that their budgets cut into 0.3 ms ticks, and a 10 Hz background job of
+   4 ms, e.g. an estimator or log flush.  Reports how late each task starts
+   after its release and how many releases finish past their deadlines.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include "RFT_scheduler.hpp"
+#include "bench.hpp"
+
+static const float SECONDS = 20;
+
+// Cost of a pass of the main loop with nothing to do
+static const float IDLE = 5e-6;
+
+class Clock : public rft::Board {
+
+    public:
+
+        float now = 0;
+
+        void spend(float seconds)
+        {
+            now += seconds;
+        }
+
+    protected:
+
+        float getTime(void) override
+        {
+            return now;
+        }
+};
+
+static Clock board;
+
+// Periodic work of chunks, each costing the same; a release that isn't
+// finished keeps its place and continues on the next call
+class Job {
+
+    public:
+
+        const char * name;
+        float period;
+        float chunk;
+        uint8_t chunks;
+
+        // Next nominal release
+        float next = 0;
+
+        uint8_t left = 0;
+
+        float worstLatency = 0;
+        uint32_t releases = 0;
+        uint32_t misses = 0;
+
+        Job(const char * n, float p, float c, uint8_t k)
+            : name(n), period(p), chunk(c), chunks(k) { }
+
+        bool due(void)
+        {
+            return left > 0 || board.now >= next;
+        }
+
+        // Does one chunk, or all that are left; returns true when the
+        // release is finished
+        bool step(bool all)
+        {
+            if (left == 0) {
+                float latency = board.now - next;
+                worstLatency = latency > worstLatency ? latency : worstLatency;
+                left = chunks;
+                releases++;
+            }
+
+            do {
+                board.spend(chunk);
+                left--;
+            } while (all && left > 0);
+
+            if (left > 0) {
+                return false;
+            }
+
+            // Deadline is the next release
+            next += period;
+            if (board.now > next) {
+                misses++;
+                while (next <= board.now) {
+                    next += period;
+                }
+            }
+
+            return true;
+        }
+};
+
+static Job control("control 500 Hz",      0.002, 0.0002, 1);
+static Job serial1("serial 66 Hz",        1/66., 0.0003, 4);
+static Job serial2("telemetry 66 Hz",     1/66., 0.0003, 4);
+static Job background("background 10 Hz", 0.1,   0.0005, 8);
+
+static Job * jobs[4] = {&control, &serial1, &serial2, &background};
+
+static void reset(void)
+{
+    for (uint8_t k=0; k<4; ++k) {
+        jobs[k]->next = 0;
+        jobs[k]->left = 0;
+        jobs[k]->worstLatency = 0;
+        jobs[k]->releases = 0;
+        jobs[k]->misses = 0;
+    }
+
+    board.now = 0;
+}
+
+static void report(const char * title)
+{
+    printf("%s\n", title);
+    for (uint8_t k=0; k<4; ++k) {
+        printf("    %-18s worst start %6.2f ms, %5u of %5u releases late\n",
+                jobs[k]->name, 1000 * jobs[k]->worstLatency,
+                jobs[k]->misses, jobs[k]->releases);
+    }
+    printf("\n");
+}
+
+// The old update(): every task in a fixed order on each pass; serial
+// tasks stop at their budgets, but other work runs to the end
+static void fixedOrder(bool chunked)
+{
+    reset();
+
+    while (board.now < SECONDS) {
+
+        board.spend(IDLE);
+
+        for (uint8_t k=0; k<4; ++k) {
+            if (jobs[k]->due()) {
+                jobs[k]->step(k == 3 && !chunked);
+            }
+        }
+    }
+}
+
+static bool runJob(void * context, uint8_t index)
+{
+    (void)context;
+    return jobs[index]->step(false);
+}
+
+static void scheduled(void)
+{
+    reset();
+
+    rft::Scheduler scheduler;
+
+    scheduler.add(runJob, NULL, 0, jobs[0]->period, rft::Scheduler::CONTROL);
+    scheduler.add(runJob, NULL, 1, jobs[1]->period, rft::Scheduler::COMMS);
+    scheduler.add(runJob, NULL, 2, jobs[2]->period, rft::Scheduler::COMMS);
+    scheduler.add(runJob, NULL, 3, jobs[3]->period,
+            rft::Scheduler::BACKGROUND);
+
+    scheduler.begin(&board);
+
+    while (board.now < SECONDS) {
+        board.spend(IDLE);
+        scheduler.run(&board);
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    fixedOrder(false);
+    report("fixed order, background job in one piece");
+
+    fixedOrder(true);
+    report("fixed order, background job yielding every 0.5 ms");
+
+    scheduled();
+    report("Scheduler, background job yielding every 0.5 ms");
+
+    // Overhead of a pass that runs four trivial tasks
+    static rft::Scheduler busy;
+    for (uint8_t k=0; k<4; ++k) {
+        busy.add([](void * context, uint8_t index) {
+                (void)context;
+                bench::sink = index;
+                return true;
+                }, NULL, k, 0, k);
+    }
+    busy.begin(&board);
+
+    bench::report("Scheduler::run, four tasks due", bench::best([](uint32_t k) {
+                (void)k;
+                busy.run(&board);
+                }));
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*
+   Telemetry throughput through the LinuxSerial pseudo-terminal, batching
+   writes per tick versus issuing one write() per byte
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include "rft_boards/realboards/linux_serial.hpp"
+#include "bench.hpp"
+
+class HostBoard : public rft::LinuxSerial {
+
+    public:
+
+        int slave = -1;
+
+        HostBoard(void)
+        {
+            slave = open(_ptyName, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        }
+
+        void send(const uint8_t * buf, uint16_t n, bool flushEachByte)
+        {
+            for (uint16_t k=0; k<n; ++k) {
+                serialWrite(buf[k], false);
+                if (flushEachByte) {
+                    serialFlush(false);
+                }
+            }
+            serialFlush(false);
+        }
+
+        uint32_t dropped(void)
+        {
+            return droppedBytes(false);
+        }
+};
+
+// Ground-station side: drain everything available
+static uint64_t drain(int fd)
+{
+    static uint8_t buf[65536];
+    uint64_t total = 0;
+    ssize_t n = 0;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        total += n;
+    }
+    return total;
+}
+
+static void run(const char * name, bool flushEachByte)
+{
+    HostBoard board;
+
+    // One MSP STATE reply: header, twelve floats, checksum
+    uint8_t frame[54] = {'$', 'M', '>', 48, 122};
+
+    static const uint32_t TICKS = 20000;
+
+    uint64_t received = 0;
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    for (uint32_t k=0; k<TICKS; ++k) {
+        board.send(frame, sizeof(frame), flushEachByte);
+        received += drain(board.slave);
+    }
+
+    double sec = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+    printf("%-30s %8.2f MB/s received, %u bytes dropped\n",
+            name, received / sec / 1e6, board.dropped());
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    run("one write() per tick", false);
+    run("one write() per byte", true);
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+   Worst-case time one SerialTask::update() takes while a burst of GCS
+   requests arrives, with and without the per-tick budgets
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include "rft_boards/realboards/linux_serial.hpp" // host timing, outbuf()
+#include "RFT_serialtask.hpp"
+#include "bench.hpp"
+
+// A board whose serial port is a pair of memory queues
+class MemoryBoard : public rft::RealBoard {
+
+    public:
+
+        uint8_t rx[65536] = {};
+        uint32_t rxHead = 0;
+        uint32_t rxTail = 0;
+
+        uint32_t txCount = 0;
+
+        float getTime(void) override
+        {
+            // Real time, so that the time budget applies
+            return std::chrono::duration<float>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+    protected:
+
+        void setLed(bool isOn) override
+        {
+            (void)isOn;
+        }
+
+        uint8_t serialAvailable(bool secondaryPort) override
+        {
+            (void)secondaryPort;
+            uint32_t n = rxTail - rxHead;
+            return n > 255 ? 255 : n;
+        }
+
+        uint8_t serialRead(bool secondaryPort) override
+        {
+            (void)secondaryPort;
+            return rx[rxHead++];
+        }
+
+        void serialWrite(uint8_t c, bool secondaryPort) override
+        {
+            (void)c;
+            (void)secondaryPort;
+            txCount++;
+        }
+};
+
+class ArmedState : public rft::State {
+
+    public:
+
+        ArmedState(void) : State(true) { }
+
+        bool safeToArm(void) override { return true; }
+};
+
+class NullActuator : public rft::Actuator {
+
+    protected:
+
+        void run(float * demands, bool olcInactive) override
+        {
+            (void)demands;
+            (void)olcInactive;
+        }
+};
+
+// Answers STATE requests with twelve floats
+class StateTask : public rft::SerialTask {
+
+    public:
+
+        uint32_t replies = 0;
+
+        StateTask(uint16_t byteBudget, float timeBudget)
+        {
+            _byteBudget = byteBudget;
+            _timeBudget = timeBudget;
+        }
+
+        void tick(MemoryBoard * board, rft::Actuator * actuator,
+                  rft::State * state)
+        {
+            update(board, actuator, state);
+        }
+
+    protected:
+
+        void collectPayload(uint8_t index, uint8_t value) override
+        {
+            (void)index;
+            (void)value;
+        }
+
+        void dispatchMessage(uint8_t type) override
+        {
+            if (type == 122) {
+                prepareToSendFloats(122, 12);
+                for (uint8_t k=0; k<12; ++k) {
+                    sendFloat(k);
+                }
+                completeSend();
+                replies++;
+            }
+        }
+};
+
+static void run(const char * name, uint16_t byteBudget, float timeBudget)
+{
+    static const uint32_t REQUESTS = 1000;
+
+    static MemoryBoard board;
+    board.rxHead = 0;
+    board.rxTail = 0;
+    board.txCount = 0;
+
+    // A burst of requests, all waiting at once
+    for (uint32_t k=0; k<REQUESTS; ++k) {
+        static const uint8_t request[] = {'$', 'M', '<', 0, 122, 122};
+        for (uint8_t j=0; j<sizeof(request); ++j) {
+            board.rx[board.rxTail++] = request[j];
+        }
+    }
+
+    NullActuator actuator;
+    ArmedState state;
+    StateTask task(byteBudget, timeBudget);
+
+    double worst = 0;
+    uint32_t ticks = 0;
+
+    while (true) {
+
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+
+        task.tick(&board, &actuator, &state);
+
+        double us = std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count();
+
+        worst = us > worst ? us : worst;
+        ticks++;
+
+        if (board.rxHead == board.rxTail && task.replies == REQUESTS) {
+            break;
+        }
+
+        // Next pass of the main loop, a little later
+        std::chrono::steady_clock::time_point wait =
+            std::chrono::steady_clock::now() + std::chrono::microseconds(200);
+        while (std::chrono::steady_clock::now() < wait) {
+        }
+    }
+
+    printf("%-26s worst update %8.1f us, %u replies in %u ticks, "
+           "%u ticks deferred\n",
+           name, worst, task.replies, ticks, task.deferredTicks());
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    run("unbudgeted", 65535, 1.0);
+    run("256 bytes, 1 ms", 256, 0.001);
+    run("64 bytes, 100 us", 64, 0.0001);
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+/*
+   Scaling of the lockstep SITL runner across cores, using many independent
+   RFTPure instances each closing a PID loop around a toy plant.  Exits with
+   status 1 if the results depend on the number of threads.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include <math.h>
+
+#include "RFT_pure.hpp"
+#include "rft_closedloops/pidcontroller.hpp"
+#include "rft_sitl/runner.hpp"
+#include "bench.hpp"
+
+static const float DT = 1.f / 1000;
+
+class ToyState : public rft::State {
+
+    public:
+
+        float y = 0;
+
+        ToyState(void) : State(true) { }
+
+        bool safeToArm(void) override { return true; }
+};
+
+class ToyBoard : public rft::Board {
+
+    public:
+
+        float time = 0;
+
+        float getTime(void) override { return time; }
+};
+
+class ToyReceiver : public rft::OpenLoopController {
+
+    public:
+
+        float target = 1;
+
+        void getDemands(float * demands) override { demands[0] = target; }
+};
+
+class ToyActuator : public rft::Actuator {
+
+    public:
+
+        float u = 0;
+
+        void run(float * demands, bool olcInactive) override
+        {
+            (void)olcInactive;
+            u = demands[0];
+        }
+};
+
+class ToyPid : public rft::PidController {
+
+    public:
+
+        ToyPid(float kp) : PidController(0, rft::Pid(kp, 1, 0.01)) { }
+
+        float getMeasurement(rft::State * state) override
+        {
+            return ((ToyState *)state)->y;
+        }
+};
+
+class ToyFirmware : public rft::RFTPure {
+
+    public:
+
+        ToyFirmware(ToyBoard * b, ToyReceiver * r, ToyActuator * a)
+            : RFTPure(b, r, a) { }
+
+        void begin(void) { RFTPure::begin(); }
+
+        void update(ToyState * state) { RFTPure::update(state); }
+};
+
+class ToyVehicle : public rft::SitlVehicle {
+
+    private:
+
+        ToyBoard _board;
+        ToyReceiver _receiver;
+        ToyActuator _actuator;
+        ToyState _state;
+        ToyPid _pid;
+        ToyFirmware _firmware;
+
+    public:
+
+        ToyVehicle(float kp)
+            : _pid(kp), _firmware(&_board, &_receiver, &_actuator)
+        {
+            _firmware.addClosedLoopController(&_pid);
+        }
+
+        void begin(void) override
+        {
+            _firmware.begin();
+        }
+
+        bool step(void) override
+        {
+            _board.time += DT;
+            _firmware.update(&_state);
+            _state.y += (_actuator.u - 0.1f * _state.y) * DT;
+            return _state.y < 100;
+        }
+
+        float y(void) { return _state.y; }
+};
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    static const uint32_t VEHICLES = 2000;
+    static const uint32_t STEPS = 5000;
+
+    ToyVehicle * vehicles[VEHICLES];
+    for (uint32_t k=0; k<VEHICLES; ++k) {
+        vehicles[k] = new ToyVehicle(0.5f + k * 1e-3f);
+    }
+
+    uint32_t cores = std::thread::hardware_concurrency();
+    cores = cores > 0 ? cores : 1;
+
+    double checksum0 = 0;
+    bool mismatch = false;
+
+    // Powers of two, then all the cores if that isn't one
+    for (uint32_t threads=1; threads<=cores;
+            threads = threads < cores && threads*2 > cores ? cores : threads*2) {
+
+        rft::WorkStealingPool pool(threads);
+        rft::SitlRunner runner(pool);
+
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        uint64_t steps = runner.run((rft::SitlVehicle **)vehicles, VEHICLES,
+                STEPS);
+        double sec = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+
+        // Instances are independent, so results can't depend on threading
+        double checksum = 0;
+        for (uint32_t k=0; k<VEHICLES; ++k) {
+            checksum += vehicles[k]->y();
+        }
+        if (threads == 1) {
+            checksum0 = checksum;
+        }
+
+        printf("%2u threads: %12.0f vehicle-steps/sec %s\n", threads,
+                steps / sec, checksum == checksum0 ? "" : "(MISMATCH)");
+
+        mismatch |= checksum != checksum0;
+
+        // Start over from a fresh state
+        for (uint32_t k=0; k<VEHICLES; ++k) {
+            delete vehicles[k];
+            vehicles[k] = new ToyVehicle(0.5f + k * 1e-3f);
+        }
+    }
+
+    for (uint32_t k=0; k<VEHICLES; ++k) {
+        delete vehicles[k];
+    }
+
+    return mismatch ? 1 : 0;
+}
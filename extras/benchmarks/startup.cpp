@@ -0,0 +1,252 @@
+/*
+   Time from power-on to ready-to-arm, with a gyro that calibrates its bias,
+   a barometer that averages its ground level, and ESCs that need to see
+   minimum throttle for a while before they accept commands
+
+   Reports when each device became ready and when the vehicle could arm with
+   the staged startup, against the old sequence of a one-second LED flash
+   followed by each device's startup in turn.  The receiver's arming switch
+   is flipped early, so the arming time shows that arming waits for startup.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include "RFT_pure.hpp"
+#include "rft_boards/simboard.hpp"
+#include "rft_sitl/random.hpp"
+#include "bench.hpp"
+
+static const float DT = 0.001;  // 1 kHz main loop
+
+// Seconds of samples or settling each device needs
+static const float GYRO_SECONDS = 0.5;
+static const float BARO_SECONDS = 0.3;
+static const float ESC_SECONDS  = 0.4;
+
+// The old RealBoard::begin() flashed the LED for this long first
+static const float OLD_FLASH_SECONDS = 1.0;
+
+static const float SWITCH_TIME = 0.1;
+
+class Clock : public rft::SimBoard {
+
+    public:
+
+        uint32_t flashes = 0;
+
+        Clock(void) : SimBoard(DT) { }
+
+        float now(void) { return getTime(); }
+
+    protected:
+
+        void showStartingStatus(void) override
+        {
+            flashes++;
+        }
+};
+
+// Averages one sample per call over its calibration time
+class CalibratingSensor : public rft::Sensor {
+
+    private:
+
+        rft::FastRandom _random;
+
+        float _seconds = 0;
+        float _offset = 0;
+        float _begin = 0;
+        float _sum = 0;
+        uint32_t _count = 0;
+
+        Clock * _clock = NULL;
+
+    public:
+
+        float readyTime = -1;
+        float estimate = 0;
+
+        CalibratingSensor(Clock * clock, float seconds, float offset,
+                          uint32_t seed)
+            : _random(seed)
+        {
+            _clock = clock;
+            _seconds = seconds;
+            _offset = offset;
+        }
+
+    protected:
+
+        void begin(void) override
+        {
+            _begin = _clock->now();
+        }
+
+        bool ready(float time) override
+        {
+            if (readyTime >= 0) {
+                return true;
+            }
+
+            _sum += _offset + _random.gaussian(0.01);
+            _count++;
+
+            if (time - _begin < _seconds) {
+                return false;
+            }
+
+            estimate = _sum / _count;
+            readyTime = time;
+            return true;
+        }
+
+        void modifyState(rft::State * state, float time) override
+        {
+            (void)state;
+            (void)time;
+        }
+};
+
+class EscActuator : public rft::Actuator {
+
+    private:
+
+        Clock * _clock = NULL;
+        float _begin = 0;
+
+    public:
+
+        float readyTime = -1;
+        uint32_t runsBeforeReady = 0;
+
+        EscActuator(Clock * clock)
+        {
+            _clock = clock;
+        }
+
+    protected:
+
+        void begin(void) override
+        {
+            // Minimum throttle from here on
+            _begin = _clock->now();
+        }
+
+        bool ready(float time) override
+        {
+            if (readyTime < 0 && time - _begin >= ESC_SECONDS) {
+                readyTime = time;
+            }
+            return readyTime >= 0;
+        }
+
+        void run(float * demands, bool olcInactive) override
+        {
+            (void)demands;
+            (void)olcInactive;
+            runsBeforeReady += readyTime < 0;
+        }
+};
+
+// Sends a frame every tick, with the arming switch off until SWITCH_TIME
+class Receiver : public rft::OpenLoopController {
+
+    public:
+
+        Clock * clock = NULL;
+
+    protected:
+
+        void getDemands(float * demands) override
+        {
+            demands[0] = 0;
+        }
+
+        bool inactive(void) override
+        {
+            return true;
+        }
+
+        bool inArmedState(void) override
+        {
+            return clock->now() >= SWITCH_TIME;
+        }
+};
+
+class VehicleState : public rft::State {
+
+    public:
+
+        bool isArmed(void) { return armed; }
+
+        bool safeToArm(void) override { return true; }
+};
+
+class Firmware : public rft::RFTPure {
+
+    public:
+
+        Firmware(rft::Board * b, rft::OpenLoopController * r,
+                 rft::Actuator * a)
+            : RFTPure(b, r, a) { }
+
+        void begin(void) { RFTPure::begin(); }
+
+        void update(rft::State * state) { RFTPure::update(state); }
+};
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    Clock clock;
+
+    CalibratingSensor gyro(&clock, GYRO_SECONDS, 0.02, 1);
+    CalibratingSensor baro(&clock, BARO_SECONDS, 101.3, 2);
+
+    EscActuator escs(&clock);
+
+    Receiver receiver;
+    receiver.clock = &clock;
+
+    VehicleState state;
+
+    Firmware firmware(&clock, &receiver, &escs);
+    firmware.addSensor(&gyro);
+    firmware.addSensor(&baro);
+    firmware.begin();
+
+    float armTime = -1;
+
+    // The arming switch is on from SWITCH_TIME
+    while (armTime < 0 && clock.now() < 5) {
+
+        clock.step();
+        firmware.update(&state);
+
+        if (state.isArmed()) {
+            armTime = clock.now();
+        }
+    }
+
+    printf("gyro calibrated       %6.3f s (bias %.4f, true 0.02)\n",
+            gyro.readyTime, gyro.estimate);
+    printf("baro settled          %6.3f s\n", baro.readyTime);
+    printf("ESCs armed            %6.3f s\n", escs.readyTime);
+    printf("ready                 %6.3f s, %u LED ticks\n",
+            firmware.startupSeconds(), clock.flashes);
+    printf("armed                 %6.3f s (switch on at %.1f s)\n", armTime,
+            SWITCH_TIME);
+    printf("motor commands before ESCs ready: %u\n\n", escs.runsBeforeReady);
+
+    float old = OLD_FLASH_SECONDS + GYRO_SECONDS + BARO_SECONDS + ESC_SECONDS;
+
+    printf("power-on to ready-to-arm: %.2f s staged, %.2f s sequential "
+            "with the LED loop\n", firmware.startupSeconds(), old);
+
+    return firmware.ready() && armTime >= 0 && escs.runsBeforeReady == 0 ?
+        0 : 1;
+}
@@ -0,0 +1,183 @@
+/*
+   Telemetry scheduling on a saturated radio link: three streams of different
+   priority and size share a 19200-baud telemetry port that cannot carry even
+   the highest-priority one at its full rate, while the USB port carries
+   everything
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include "rft_boards/realboards/linux_serial.hpp" // host timing, outbuf()
+#include "RFT_serialtask.hpp"
+#include "bench.hpp"
+
+static const float DT = 0.001;
+
+class CountingBoard : public rft::RealBoard {
+
+    public:
+
+        float time = 0;
+        uint32_t bytes[2] = {};
+
+        float getTime(void) override
+        {
+            return time;
+        }
+
+    protected:
+
+        void setLed(bool isOn) override { (void)isOn; }
+
+        uint8_t serialAvailable(bool port) override { (void)port; return 0; }
+
+        uint8_t serialRead(bool port) override { (void)port; return 0; }
+
+        void serialWrite(uint8_t c, bool port) override
+        {
+            (void)c;
+            bytes[port]++;
+        }
+};
+
+class NullActuator : public rft::Actuator {
+
+    protected:
+
+        void run(float * demands, bool olcInactive) override
+        {
+            (void)demands;
+            (void)olcInactive;
+        }
+};
+
+class IdleState : public rft::State {
+
+    public:
+
+        bool safeToArm(void) override { return true; }
+};
+
+// Sends a message of count floats
+class FloatStream : public rft::TelemetryStream {
+
+    private:
+
+        uint8_t _type;
+        uint8_t _count;
+
+    public:
+
+        FloatStream(uint8_t type, uint8_t count, uint8_t priority, float rate)
+            : TelemetryStream(priority, rate, PRIMARY | TELEMETRY),
+              _type(type), _count(count)
+        {
+        }
+
+    protected:
+
+        uint8_t frameSize(void) override
+        {
+            return rft::TelemetryFrame::OVERHEAD + 4 * _count;
+        }
+
+        bool fill(rft::TelemetryFrame & frame, uint8_t maxPayload) override
+        {
+            (void)maxPayload;
+            frame.begin(_type);
+            for (uint8_t k=0; k<_count; ++k) {
+                frame.addFloat(k);
+            }
+            frame.end();
+            return true;
+        }
+};
+
+class Task : public rft::SerialTask {
+
+    public:
+
+        Task(bool port, rft::TelemetryScheduler * telemetry)
+            : SerialTask(port)
+        {
+            _sendLogRecords = false;
+            setTelemetry(telemetry);
+        }
+
+        void tick(rft::RealBoard * board, rft::Actuator * actuator,
+                  rft::State * state)
+        {
+            update(board, actuator, state);
+        }
+
+    protected:
+
+        void collectPayload(uint8_t index, uint8_t value) override
+        {
+            (void)index;
+            (void)value;
+        }
+
+        void dispatchMessage(uint8_t type) override
+        {
+            (void)type;
+        }
+};
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    static const float SECONDS = 60;
+
+    // STATE at 50 Hz alone would need 2700 bytes/s
+    FloatStream state(122, 12, 200, 50);
+    FloatStream receiver(121, 6, 100, 20);
+    rft::LogStream log(0, 20, rft::TelemetryStream::TELEMETRY);
+
+    rft::TelemetryScheduler scheduler;
+    scheduler.addStream(&state);
+    scheduler.addStream(&receiver);
+    scheduler.addStream(&log);
+    scheduler.setBandwidth(false, 11520); // USB at 115200 baud
+    scheduler.setBandwidth(true, 1920);   // radio at 19200 baud
+
+    CountingBoard board;
+    NullActuator actuator;
+    IdleState vehicle;
+
+    Task usb(false, &scheduler);
+    Task radio(true, &scheduler);
+
+    for (uint32_t k=0; k<SECONDS/DT; ++k) {
+
+        board.time = k * DT;
+
+        // A chatty firmware: 100 records a second
+        if (k % 10 == 0) {
+            RFT_LOG("tick %d\n", k);
+        }
+
+        usb.tick(&board, &actuator, &vehicle);
+        radio.tick(&board, &actuator, &vehicle);
+    }
+
+    static const char * names[2] = {"USB", "radio"};
+    static const float bandwidth[2] = {11520, 1920};
+
+    for (uint8_t port=0; port<2; ++port) {
+        printf("%-5s %6.0f of %5.0f bytes/s; frames/s: STATE %4.1f, "
+               "RECEIVER %4.1f, log %4.1f\n",
+               names[port], board.bytes[port] / SECONDS, bandwidth[port],
+               state.framesSent(port) / SECONDS,
+               receiver.framesSent(port) / SECONDS,
+               log.framesSent(port) / SECONDS);
+    }
+
+    printf("%u log records dropped\n", (unsigned)rft::Logger::dropped());
+
+    return 0;
+}
@@ -0,0 +1,244 @@
+/*
+   Signal-loss-to-motor-cut latency under injected receiver dropouts
+
+   Each trial flies a fresh firmware instance, drops the receiver signal at a
+   random time, and measures how long after the last good frame the motors
+   are cut.  The receiver's own lostSignal() is deliberately slow, so the cut
+   has to come from the watchdog.  Exits with status 1 if any trial misses
+   the deadline in the scenarios where the deadline is guaranteed, or if the
+   motors are run after the cut, as they could be when the timer fires in
+   the middle of a pass.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "RFT_pure.hpp"
+#include "rft_boards/simboard.hpp"
+#include "rft_sitl/random.hpp"
+#include "bench.hpp"
+
+static const float DT = 0.0005;         // 2 kHz main loop
+static const float FRAME_PERIOD = 0.02; // 50 Hz receiver
+static const float DEADLINE = 0.1;
+
+class Clock : public rft::SimBoard {
+
+    public:
+
+        bool timer = true;
+
+        void (*callback)(void *) = NULL;
+        void * context = NULL;
+
+        Clock(void) : SimBoard(DT) { }
+
+        float now(void) { return getTime(); }
+
+        // The timer firing now, rather than from step()
+        void interrupt(void)
+        {
+            if (callback) {
+                callback(context);
+            }
+        }
+
+    protected:
+
+        bool startTimer(float period, void (*callback)(void *),
+                        void * context) override
+        {
+            this->callback = timer ? callback : NULL;
+            this->context = context;
+            return timer && SimBoard::startTimer(period, callback, context);
+        }
+};
+
+class DroppingReceiver : public rft::OpenLoopController {
+
+    public:
+
+        Clock * clock = NULL;
+        float dropTime = 1e9;
+        float lastFrame = 0;
+        float nextFrame = 0;
+
+        // Lets time pass inside the control tick and fires the timer then,
+        // after the pass has checked for signal loss and before the motors
+        // are run
+        bool midTick = false;
+
+    protected:
+
+        void getDemands(float * demands) override
+        {
+            demands[0] = 0.5;
+
+            if (midTick) {
+                clock->step();
+                clock->interrupt();
+            }
+        }
+
+        bool ready(void) override
+        {
+            float time = clock->now();
+            if (time < dropTime && time >= nextFrame) {
+                lastFrame = time;
+                nextFrame += FRAME_PERIOD;
+                return true;
+            }
+            return false;
+        }
+
+        // A sluggish failsafe, as on receivers that hold the last frame
+        bool lostSignal(void) override
+        {
+            return clock->now() - lastFrame > 1.0;
+        }
+};
+
+class RecordingActuator : public rft::Actuator {
+
+    public:
+
+        Clock * clock = NULL;
+        float cutTime = -1;
+
+        // Motors run after the cut
+        uint32_t lateRuns = 0;
+
+    protected:
+
+        void run(float * demands, bool motorsOn) override
+        {
+            (void)demands;
+            lateRuns += motorsOn && cutTime >= 0;
+        }
+
+        void cut(void) override
+        {
+            if (cutTime < 0) {
+                cutTime = clock->now();
+            }
+        }
+};
+
+class ArmedState : public rft::State {
+
+    public:
+
+        ArmedState(void) : State(true) { }
+
+        bool safeToArm(void) override { return true; }
+};
+
+class Firmware : public rft::RFTPure {
+
+    public:
+
+        Firmware(rft::Board * b, rft::OpenLoopController * r,
+                 rft::Actuator * a)
+            : RFTPure(b, r, a)
+        {
+            setSignalDeadline(DEADLINE);
+        }
+
+        void begin(void) { RFTPure::begin(); }
+
+        void update(rft::State * state) { RFTPure::update(state); }
+};
+
+// Returns false if any trial exceeded the bound
+static bool run(const char * name, bool timer, float stall, float bound,
+        bool midTick=false)
+{
+    static const uint32_t TRIALS = 500;
+
+    rft::FastRandom random(12345);
+    std::vector<float> latencies;
+    uint32_t late = 0;
+    uint32_t lateRuns = 0;
+
+    for (uint32_t k=0; k<TRIALS; ++k) {
+
+        Clock clock;
+        clock.timer = timer;
+
+        DroppingReceiver receiver;
+        receiver.clock = &clock;
+        receiver.dropTime = 0.5f + random.uniform();
+        receiver.midTick = midTick;
+
+        RecordingActuator actuator;
+        actuator.clock = &clock;
+
+        ArmedState state;
+
+        Firmware firmware(&clock, &receiver, &actuator);
+        firmware.begin();
+
+        // On past the cut a little, to catch the motors being run again
+        while ((actuator.cutTime < 0 || clock.now() < actuator.cutTime + 0.05f)
+                && clock.now() < 5) {
+
+            clock.step();
+
+            // The main loop stalls when the signal drops, e.g. stuck
+            // waiting on a sensor bus
+            float t = clock.now();
+            if (t < receiver.dropTime || t > receiver.dropTime + stall) {
+                firmware.update(&state);
+            }
+        }
+
+        float latency = actuator.cutTime - receiver.lastFrame;
+        latencies.push_back(latency);
+
+        if (actuator.cutTime < 0 || latency > bound) {
+            late++;
+        }
+
+        lateRuns += actuator.lateRuns;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("%-34s latency ms: median %6.1f  p99 %6.1f  max %6.1f  "
+           "(bound %5.1f, %u late, %u motor runs after cut)\n",
+           name,
+           1e3 * latencies[TRIALS/2],
+           1e3 * latencies[TRIALS*99/100],
+           1e3 * latencies[TRIALS-1],
+           1e3 * bound, late, lateRuns);
+
+    return late == 0 && lateRuns == 0;
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    bool ok = true;
+
+    // Checked every loop: one loop period past the deadline at most
+    ok &= run("loop running, no timer", false, 0, DEADLINE + 2*DT);
+
+    // Timer every deadline/4 keeps working while the loop is stuck
+    ok &= run("loop stalled 0.5 s, timer", true, 0.5, 1.25f*DEADLINE + 2*DT);
+
+    // Without the timer, the cut waits for the loop; not guaranteed
+    run("loop stalled 0.5 s, no timer", false, 0.5, 1.25f*DEADLINE + 2*DT);
+
+    // Timer firing between the signal check and the motors in a pass
+    ok &= run("timer during control tick", true, 0, DEADLINE + 2*DT, true);
+
+    printf(ok ? "PASS\n" : "FAIL\n");
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+'''
+Host-side report of the RAM a firmware uses, from the entries that
+RFT_footprint.hpp keeps
+
+Asks for each entry in turn with FOOTPRINT_GET and prints the replies as a
+table, from a serial port or a SITL socket:
+
+    footprint.py -s /dev/ttyACM0
+
+or prints whatever replies are in a captured byte stream:
+
+    footprint.py -f capture.bin
+
+Copyright (C) 2021 Simon D. Levy
+
+MIT License
+'''
+
+import argparse
+import struct
+import sys
+import time
+
+MSP_ID = 252
+
+FOOTPRINT_GET = 219
+
+# Index, count, size, capacity, used; then the name
+HEADER = '<BBIII'
+
+HEADER_SIZE = struct.calcsize(HEADER)
+
+
+def request(index):
+    '''
+    A FOOTPRINT_GET message asking for one entry
+    '''
+    payload = struct.pack('<h', index)
+    crc = len(payload) ^ FOOTPRINT_GET
+    for byte in payload:
+        crc ^= byte
+    return (b'$M<' + bytes([len(payload), FOOTPRINT_GET]) + payload +
+            bytes([crc]))
+
+
+class _MspReader(object):
+    '''
+    Collects MSP_ID messages from a byte stream, ignoring everything else
+    '''
+
+    def __init__(self):
+
+        self.state = 0
+        self.entries = {}
+        self.count = None
+
+    def parse(self, data):
+
+        for byte in data:
+
+            if self.state == 0:
+                self.state = 1 if byte == ord('$') else 0
+
+            elif self.state == 1:
+                self.state = 2 if byte == ord('M') else 0
+
+            elif self.state == 2:
+                self.state = 3 if byte == ord('>') else 0
+
+            elif self.state == 3:
+                self.size = byte
+                self.crc = byte
+                self.state = 4
+
+            elif self.state == 4:
+                self.type = byte
+                self.crc ^= byte
+                self.payload = bytearray()
+                self.state = 5 if self.size > 0 else 6
+
+            elif self.state == 5:
+                self.payload.append(byte)
+                self.crc ^= byte
+                if len(self.payload) == self.size:
+                    self.state = 6
+
+            else:
+                if (self.crc == byte and self.type == MSP_ID and
+                        len(self.payload) >= HEADER_SIZE):
+                    self.collect(self.payload)
+                self.state = 0
+
+    def collect(self, payload):
+
+        index, count, size, capacity, used = struct.unpack_from(HEADER,
+                                                                payload)
+        self.count = count
+
+        # Out of range
+        if index == 0xFF:
+            return
+
+        name = payload[HEADER_SIZE:].decode('latin-1')
+        self.entries[index] = (name, size, capacity, used)
+
+    def done(self):
+
+        return self.count is not None and len(self.entries) >= self.count
+
+
+def report(entries, count):
+
+    print('%-20s %8s %8s %8s %8s' % ('', 'size', 'buffer', 'used', 'unused'))
+
+    total = unused = 0
+
+    for index in sorted(entries):
+
+        name, size, capacity, used = entries[index]
+
+        # The stack isn't part of any object; an unknown capacity is zero
+        if capacity > 0:
+            print('%-20s %8d %8d %8d %8d' % (name, size, capacity, used,
+                                             capacity - used))
+            unused += capacity - used
+        else:
+            print('%-20s %8d %8s %8d' % (name, size, '', used))
+
+        total += size
+
+    print('%-20s %8d %8s %8s %8d' % ('total', total, '', '', unused))
+
+    if count is not None and len(entries) < count:
+        sys.stderr.write('%d of %d entries missing\n' %
+                         (count - len(entries), count))
+
+
+def _open(cmdargs):
+    '''
+    Returns functions reading a chunk of bytes from the chosen source and
+    writing to it; a captured stream can't be written
+    '''
+
+    if cmdargs.serial is not None:
+        try:
+            import serial
+        except ImportError:
+            sys.stderr.write('import serial failed; make sure pyserial is installed\n')
+            sys.exit(1)
+        port = serial.Serial(cmdargs.serial, 115200, timeout=0.1)
+        return lambda: port.read(max(1, port.in_waiting)), port.write
+
+    if cmdargs.unix is not None:
+        import socket
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        sock.connect(cmdargs.unix)
+        sock.settimeout(0.1)
+
+        def read():
+            try:
+                return sock.recv(4096)
+            except socket.timeout:
+                return b''
+
+        return read, sock.sendall
+
+    infile = open(cmdargs.filename, 'rb')
+    return lambda: infile.read(65536), None
+
+
+def main():
+
+    argparser = argparse.ArgumentParser(description='Report RAM footprint')
+
+    source = argparser.add_mutually_exclusive_group(required=True)
+    source.add_argument('-s', '--serial', help='read from serial port')
+    source.add_argument('-u', '--unix', help='read from Unix-domain socket (SITL)')
+    source.add_argument('-f', '--filename', help='read from a captured byte stream')
+    argparser.add_argument('-t', '--timeout', type=float, default=5,
+                           help='seconds to wait for replies')
+
+    cmdargs = argparser.parse_args()
+
+    reader = _MspReader()
+    read, write = _open(cmdargs)
+
+    if write is None:
+        while True:
+            data = read()
+            if not data:
+                break
+            reader.parse(data)
+
+    else:
+        # Entry 0 first, which also tells how many there are; then any
+        # still missing, again until the timeout
+        deadline = time.time() + cmdargs.timeout
+        while not reader.done() and time.time() < deadline:
+            missing = [k for k in range(reader.count or 1)
+                       if k not in reader.entries]
+            for index in missing:
+                write(request(index))
+                reader.parse(read())
+
+    report(reader.entries, reader.count)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+'''
+Host-side decoder for RFT_LOG() records
+
+The firmware sends each record as a sixteen-bit hash of its format string plus
+the binary arguments, so the text has to be rebuilt here from a table of the
+format strings.  The table is generated by scanning the firmware sources for
+RFT_LOG() calls:
+
+    rftlog.py table -o formats.json ~/Documents/Arduino/libraries
+
+and then used to decode records from a serial port, a SITL socket or a file
+captured from either:
+
+    rftlog.py decode -t formats.json -s /dev/ttyACM0
+
+Copyright (C) 2021 Simon D. Levy
+
+MIT License
+'''
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+MSP_ID = 253
+
+HEADER_SIZE = 3
+
+ARG_SIZE = 5
+
+SOURCE_EXTENSIONS = ('.h', '.hpp', '.c', '.cpp', '.ino')
+
+# The format string is the first argument: a single C string literal
+LOG_CALL = re.compile(r'RFT_LOG\s*\(\s*"((?:[^"\\]|\\.)*)"')
+
+
+def format_id(fmt):
+    '''
+    Must match Logger::formatId(): FNV-1a folded to sixteen bits, never zero
+    '''
+    h = 2166136261
+    for c in fmt.encode('latin-1'):
+        h = ((h ^ c) * 16777619) & 0xFFFFFFFF
+    h = (h ^ (h >> 16)) & 0xFFFF
+    return h if h else 1
+
+
+# C length modifiers, which Python's % takes only one of (and ignores); a
+# literal %% is matched too, so that it is left alone
+LENGTH_MODIFIER = re.compile(r'%%|(%[-+ #0]*\d*(?:\.\d+)?)(?:hh|ll|[hlLjzt])')
+
+
+def python_format(fmt):
+
+    return LENGTH_MODIFIER.sub(lambda m: m.group(1) or m.group(0), fmt)
+
+
+def unescape(literal):
+
+    return literal.encode('latin-1').decode('unicode_escape')
+
+
+def scan(paths):
+
+    table = {}
+
+    for path in paths:
+
+        files = [path]
+
+        if os.path.isdir(path):
+            files = [os.path.join(d, f)
+                     for d, _, names in os.walk(path)
+                     for f in names if f.endswith(SOURCE_EXTENSIONS)]
+
+        for filename in files:
+            for literal in LOG_CALL.findall(open(filename, errors='ignore').read()):
+                fmt = unescape(literal)
+                fid = format_id(fmt)
+                if fid in table and table[fid] != fmt:
+                    sys.stderr.write('Format ID collision: "%s" and "%s"\n' %
+                                     (table[fid], fmt))
+                    sys.exit(1)
+                table[fid] = fmt
+
+    return table
+
+
+def decode_records(payload, table):
+    '''
+    Yields the text of each record in an MSP_ID payload
+    '''
+    k = 0
+
+    while k + HEADER_SIZE <= len(payload):
+
+        fid, size = struct.unpack_from('<HB', payload, k)
+
+        values = []
+        j = k + HEADER_SIZE
+        while j < k + size:
+            tag = chr(payload[j])
+            raw = payload[j+1:j+ARG_SIZE]
+            j += ARG_SIZE
+            # 64-bit integers: the high word follows in a slot of its own
+            if tag in 'qQ':
+                raw += payload[j+1:j+ARG_SIZE]
+                j += ARG_SIZE
+            values.append(struct.unpack('<f', raw)[0] if tag == 'f'
+                          else struct.unpack('<i', raw)[0] if tag == 'i'
+                          else struct.unpack('<q', raw)[0] if tag == 'q'
+                          else struct.unpack('<Q', raw)[0] if tag == 'Q'
+                          else chr(raw[0]) if tag == 'c'
+                          else struct.unpack('<I', raw)[0])
+
+        k += size
+
+        if fid == 0:
+            yield '[%d log records dropped]\n' % values[0]
+
+        elif fid in table:
+            try:
+                yield python_format(table[fid]) % tuple(values)
+            except (TypeError, ValueError):
+                yield '%s %% %s\n' % (table[fid].rstrip(), values)
+
+        else:
+            yield '[unknown format %04x] %s\n' % (fid, values)
+
+
+class _MspReader(object):
+    '''
+    Collects MSP_ID messages from a byte stream, ignoring everything else
+    '''
+
+    def __init__(self, table):
+
+        self.table = table
+        self.state = 0
+
+    def parse(self, data):
+
+        for byte in data:
+
+            if self.state == 0:
+                self.state = 1 if byte == ord('$') else 0
+
+            elif self.state == 1:
+                self.state = 2 if byte == ord('M') else 0
+
+            elif self.state == 2:
+                self.state = 3 if byte == ord('>') else 0
+
+            elif self.state == 3:
+                self.size = byte
+                self.crc = byte
+                self.state = 4
+
+            elif self.state == 4:
+                self.type = byte
+                self.crc ^= byte
+                self.payload = bytearray()
+                self.state = 5 if self.size > 0 else 6
+
+            elif self.state == 5:
+                self.payload.append(byte)
+                self.crc ^= byte
+                if len(self.payload) == self.size:
+                    self.state = 6
+
+            else:
+                if self.crc == byte and self.type == MSP_ID:
+                    for text in decode_records(self.payload, self.table):
+                        sys.stdout.write(text)
+                    sys.stdout.flush()
+                self.state = 0
+
+
+def _open(cmdargs):
+    '''
+    Returns a function reading a chunk of bytes from the chosen source
+    '''
+
+    if cmdargs.serial is not None:
+        try:
+            import serial
+        except ImportError:
+            sys.stderr.write('import serial failed; make sure pyserial is installed\n')
+            sys.exit(1)
+        port = serial.Serial(cmdargs.serial, 115200, timeout=0.1)
+        return lambda: port.read(max(1, port.in_waiting))
+
+    if cmdargs.unix is not None:
+        import socket
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        sock.connect(cmdargs.unix)
+        return lambda: sock.recv(4096)
+
+    infile = open(cmdargs.filename, 'rb')
+    return lambda: infile.read(65536)
+
+
+def main():
+
+    argparser = argparse.ArgumentParser(description='Decode RFT_LOG() records')
+
+    subparsers = argparser.add_subparsers(dest='command')
+
+    table = subparsers.add_parser('table', help='generate the format table from sources')
+    table.add_argument('paths', nargs='+', help='source files or directories')
+    table.add_argument('-o', '--outfile', default='formats.json', help='output file')
+
+    decode = subparsers.add_parser('decode', help='decode log records')
+    decode.add_argument('-t', '--table', default='formats.json', help='format table')
+    source = decode.add_mutually_exclusive_group(required=True)
+    source.add_argument('-s', '--serial', help='read from serial port')
+    source.add_argument('-u', '--unix', help='read from Unix-domain socket (SITL)')
+    source.add_argument('-f', '--filename', help='read from a captured byte stream')
+
+    cmdargs = argparser.parse_args()
+
+    if cmdargs.command == 'table':
+        formats = scan(cmdargs.paths)
+        json.dump({'%04x' % fid: fmt for fid, fmt in sorted(formats.items())},
+                  open(cmdargs.outfile, 'w'), indent=2)
+        print('Wrote %d formats to %s' % (len(formats), cmdargs.outfile))
+
+    elif cmdargs.command == 'decode':
+        formats = {int(fid, 16): fmt for fid, fmt in
+                   json.load(open(cmdargs.table)).items()}
+        reader = _MspReader(formats)
+        read = _open(cmdargs)
+        while True:
+            data = read()
+            if not data:
+                break
+            reader.parse(data)
+
+    else:
+        argparser.print_help()
+
+
+if __name__ == '__main__':
+    main()
@@ -76,6 +76,18 @@ class CodeEmitter(object):
 
 class Cpp_Emitter(CodeEmitter):
 
+    # Handler bodies for the messages rft::SerialTask implements, which
+    # answer from the ParameterStore given to SerialTask::setParameters()
+    LIBRARY_HANDLERS = {
+        'PARAM_VALUE': 'describeParameter(index, count, type, name, value, '
+                       'minimum, maximum);',
+        'PARAM_STORE': 'describeStore(count, layout, checksum, ok);',
+        'PARAM_GET': 'sendParameter<PARAM_VALUE>(index);',
+        'PARAM_SET': 'setParameter<PARAM_VALUE>(index, value);',
+        'PARAM_SAVE': 'saveParameters<PARAM_STORE>(reload);',
+        'FOOTPRINT_GET': 'sendFootprint(index);',
+    }
+
     def __init__(self, msgdict):
 
         CodeEmitter.__init__(self, msgdict,
@@ -83,6 +95,8 @@ class Cpp_Emitter(CodeEmitter):
 
     def emit(self):
 
+        self._emit_messages()
+
         # Open output file
         output = self._openw('serialtask.hpp')
 
@@ -97,6 +111,7 @@ class Cpp_Emitter(CodeEmitter):
         output.write('#include <RFT_actuator.hpp>\n')
         output.write('#include <RFT_parser.hpp>\n')
         output.write('#include <RFT_serialtask.hpp>\n\n')
+        output.write('#include "messages.hpp"\n\n')
 
         # Add namespace
         output.write('namespace /* XXX */ {\n\n')
@@ -125,7 +140,8 @@ class Cpp_Emitter(CodeEmitter):
             self._write_params(output, argtypes, argnames,
                                ampersand=('&' if msgid < 200 else ''))
             output.write('\n            {')
-            output.write('\n                // XXX')
+            output.write('\n                ' +
+                         Cpp_Emitter.LIBRARY_HANDLERS.get(msgtype, '// XXX'))
             output.write('\n            }\n')
 
         output.write('\n        protected:\n\n')
@@ -150,39 +166,26 @@ class Cpp_Emitter(CodeEmitter):
             argnames = self._getargnames(msgstuff)
             argtypes = self._getargtypes(msgstuff)
 
-            output.write('                    case %s:' %
-                         self.msgdict[msgtype][0])
+            output.write('                    case %s::ID:' % msgtype)
             output.write('\n                        {')
             nargs = len(argnames)
-            offset = 0
             for k in range(nargs):
                 argname = argnames[k]
                 argtype = argtypes[k]
                 decl = self.typedict[argtype]
                 output.write('\n                            ' +
                              decl + ' ' + argname + ' = 0;')
-                if msgid >= 200:
-                    fmt = 'memcpy(&%s,  &_payload[%d], sizeof(%s));\n'
-                    output.write('\n                            ')
-                    output.write(fmt % (argname, offset, decl))
-                offset += self.sizedict[argtype]
+            if msgid >= 200:
+                output.write('\n                            %s::deserialize(_payload, %s);' %
+                             (msgtype, ', '.join(argnames)))
             output.write('\n                            handle_%s%s(' %
                          (msgtype, '_Request' if msgid < 200 else ''))
-            for k in range(nargs):
-                output.write(argnames[k])
-                if k < nargs-1:
-                    output.write(', ')
+            output.write(', '.join(argnames))
             output.write(');\n')
             if msgid < 200:
-                # XXX enforce uniform type for now
-                argtype = argtypes[0].capitalize()
                 output.write('                            ')
-                output.write('prepareToSend%ss(command, %d);\n' % (argtype, nargs))
-                for argname in argnames:
-                    output.write('                            send%s(%s);\n' %
-                                 (argtype, argname))
-                output.write('                            ')
-                output.write('completeSend();\n')
+                output.write('sendMessage<%s>(%s);\n' %
+                             (msgtype, ', '.join(argnames)))
             output.write('                        } break;\n\n')
 
         output.write('                } // switch (_command)\n\n')
@@ -190,6 +193,33 @@ class Cpp_Emitter(CodeEmitter):
         output.write('        }; // class SerialTask\n\n')
         output.write('} // namespace XXX\n')
 
+    def _emit_messages(self):
+
+        output = self._openw('messages.hpp')
+
+        output.write('/*\n')
+        output.write('   MSP message layouts\n\n')
+        output.write('   AUTO-GENERATED CODE; DO NOT MODIFY\n\n')
+        output.write('   MIT License\n')
+        output.write(' */\n\n')
+        output.write('#pragma once\n\n')
+        output.write('#include <RFT_messages.hpp>\n\n')
+
+        for msgtype in self.msgdict.keys():
+
+            msgstuff = self.msgdict[msgtype]
+            msgid = msgstuff[0]
+            argtypes = self._getargtypes(msgstuff)
+
+            output.write('typedef rft::MspMessage<%d%s> %s;\n' %
+                         (msgid,
+                          ''.join(', ' + self.typedict[t] for t in argtypes),
+                          msgtype))
+
+            # Catches a type table that disagrees with the sizes above
+            output.write('static_assert(%s::PAYLOAD_SIZE == %d, "%s");\n\n' %
+                         (msgtype, self._paysize(argtypes), msgtype))
+
 
 # Python emitter ==============================================================
 
@@ -214,60 +244,95 @@ class Python_Emitter(CodeEmitter):
         self._write('\n\nimport abc')
         self._write('\n\n\nclass MspParser(metaclass=abc.ABCMeta):')
 
+        # Emit payload and checksum layouts
+        self._write('\n\n    # Payload layout and checksum layout, by message ID.  The checksum')
+        self._write('\n    # layout covers the size, type, payload and checksum bytes as 64-bit')
+        self._write('\n    # words and leftover bytes, which XOR to zero for a good message.')
+        self._write('\n    LAYOUTS = {')
+        for msgtype in self.msgdict.keys():
+            msgstuff = self.msgdict[msgtype]
+            msgid = msgstuff[0]
+            if msgid < 200:
+                argtypes = self._getargtypes(msgstuff)
+                checked = self._paysize(argtypes) + 3
+                self._write('\n        %d: (struct.Struct(\'<%s\'), struct.Struct(\'<%dQ%dB\')),'
+                            % (msgid,
+                               ''.join(self.typedict[t] for t in argtypes),
+                               checked // 8, checked % 8))
+        self._write('\n    }')
+
         # Emit __init__() method
         self._write('\n\n    def __init__(self):')
-        self._write('\n        self.state = 0')
+        self._write('\n        self.buffer = bytearray()')
+        self._write('\n        self.crc_errors = 0')
+        self._write('\n        self.needed = 0')
+        self._write('\n        self.handlers = {')
+        for msgtype in self.msgdict.keys():
+            msgstuff = self.msgdict[msgtype]
+            msgid = msgstuff[0]
+            if msgid < 200:
+                self._write('\n            %d: (self.handle_%s,) + MspParser.LAYOUTS[%d],'
+                            % (msgid, msgtype, msgid))
+        self._write('\n        }')
 
         # Emit parse() method
-        self._write('\n\n    def parse(self, char):')
-        self._write('\n        byte = ord(char)\n')
-        self._write('\n        if self.state == 0:  # sync char 1')
-        self._write('\n            if byte == 36:  # $')
-        self._write('\n                self.state += 1\n')
-        self._write('\n        elif self.state == 1:  # sync char 2')
-        self._write('\n            if byte == 77:  # M')
-        self._write('\n                self.state += 1')
-        self._write('\n            else:  # restart and try again')
-        self._write('\n                self.state = 0\n')
-        self._write('\n        elif self.state == 2:  # direction')
-        self._write('\n            if byte == 62:  # >')
-        self._write('\n                self.message_direction = 1')
-        self._write('\n            else:  # <')
-        self._write('\n                self.message_direction = 0')
-        self._write('\n            self.state += 1\n')
-        self._write('\n        elif self.state == 3:')
-        self._write('\n            self.message_length_expected = byte')
-        self._write('\n            self.message_checksum = byte')
-        self._write('\n            # setup arraybuffer')
-        self._write('\n            self.message_buffer = b""')
-        self._write('\n            self.state += 1\n')
-        self._write('\n        elif self.state == 4:')
-        self._write('\n            self.message_id = byte')
-        self._write('\n            self.message_length_received = 0')
-        self._write('\n            self.message_checksum ^= byte')
-        self._write('\n            if self.message_length_expected > 0:')
-        self._write('\n                # process payload')
-        self._write('\n                self.state += 1')
-        self._write('\n            else:')
-        self._write('\n                # no payload')
-        self._write('\n                self.state += 2\n')
-        self._write('\n        elif self.state == 5:  # payload')
-        self._write('\n            self.message_buffer += char')
-        self._write('\n            self.message_checksum ^= byte')
-        self._write('\n            self.message_length_received += 1')
-        self._write('\n            if self.message_length_received >= self.message_length_expected:')
-        self._write('\n                self.state += 1\n')
-        self._write('\n        elif self.state == 6:')
-        self._write('\n            if self.message_checksum == byte:')
-        self._write('\n                # message received, process')
-        self._write('\n                self.dispatchMessage()')
+        self._write('\n\n    def parse(self, data):')
+        self._write('\n        \'\'\'')
+        self._write('\n        Parses a chunk of bytes of any length, calling the handler for')
+        self._write('\n        each complete message; a message cut off at the end of the chunk')
+        self._write('\n        is kept for the next call.')
+        self._write('\n        \'\'\'')
+        self._write('\n        if isinstance(data, str):')
+        self._write('\n            data = data.encode(\'latin-1\')\n')
+        self._write('\n        buf = self.buffer')
+        self._write('\n        buf += data')
+        self._write('\n        end = len(buf)\n')
+        self._write('\n        # Still short of the message we are waiting for')
+        self._write('\n        if end < self.needed:')
+        self._write('\n            return\n')
+        self._write('\n        handlers = self.handlers')
+        self._write('\n        pos = 0\n')
+        self._write('\n        while True:\n')
+        self._write('\n            start = buf.find(b\'$M\', pos)\n')
+        self._write('\n            if start < 0:')
+        self._write('\n                # Keep a trailing $ in case its M is in the next chunk')
+        self._write('\n                pos = end - 1 if end > 0 and buf[end-1] == 36 else end')
+        self._write('\n                needed = pos + 2')
+        self._write('\n                break\n')
+        self._write('\n            # $ M direction size type payload checksum')
+        self._write('\n            if start + 5 > end:')
+        self._write('\n                pos = start')
+        self._write('\n                needed = start + 5')
+        self._write('\n                break\n')
+        self._write('\n            size = buf[start+3]')
+        self._write('\n            stop = start + size + 6\n')
+        self._write('\n            if stop > end:')
+        self._write('\n                pos = start')
+        self._write('\n                needed = stop')
+        self._write('\n                break\n')
+        self._write('\n            handler = handlers.get(buf[start+4])\n')
+        self._write('\n            if handler is not None and handler[1].size == size:')
+        self._write('\n                crc = 0')
+        self._write('\n                for word in handler[2].unpack_from(buf, start+3):')
+        self._write('\n                    crc ^= word')
+        self._write('\n                crc ^= crc >> 32')
+        self._write('\n                crc ^= crc >> 16')
+        self._write('\n                crc ^= crc >> 8')
+        self._write('\n                good = (crc & 0xFF) == 0')
         self._write('\n            else:')
-        self._write('\n                print("code: " + str(self.message_id) + " - crc failed")')
-        self._write('\n            # Reset variables')
-        self._write('\n            self.message_length_received = 0')
-        self._write('\n            self.state = 0\n')
-        self._write('\n        else:')
-        self._write('\n            print("Unknown state detected: %d" % self.state)')
+        self._write('\n                good = MspParser.crc8(buf[start+3:stop]) == 0')
+        self._write('\n                handler = None\n')
+        self._write('\n            if not good:')
+        self._write('\n                print("code: " + str(buf[start+4]) + " - crc failed")')
+        self._write('\n                self.crc_errors += 1')
+        self._write('\n                # Resynchronize on the next $M')
+        self._write('\n                pos = start + 1')
+        self._write('\n                continue\n')
+        self._write('\n            if handler is not None:')
+        self._write('\n                handler[0](*handler[1].unpack_from(buf, start+5))\n')
+        self._write('\n            pos = stop\n')
+        self._write('\n        del buf[:pos]')
+        self._write('\n        self.needed = needed - pos')
 
         # Emit crc8() method
         self._write('\n\n    @staticmethod')
@@ -277,21 +342,6 @@ class Python_Emitter(CodeEmitter):
         self._write('\n            crc ^= c')
         self._write('\n        return crc')
 
-        # Emit dispatchMeessage() method
-        self._write('\n\n    def dispatchMessage(self):')
-        for msgtype in self.msgdict.keys():
-            msgstuff = self.msgdict[msgtype]
-            msgid = msgstuff[0]
-            if msgid < 200:
-                self._write('\n\n        if self.message_id == %d:\n'
-                            % msgstuff[0])
-                self._write('            self.handle_%s(*struct.unpack(\'=' %
-                            msgtype)
-                for argtype in self._getargtypes(msgstuff):
-                    self._write('%s' % self.typedict[argtype])
-                self._write("\'" + ', self.message_buffer))')
-        self._write('\n\n        return')
-
         # Emit handler methods for parser
         for msgtype in self.msgdict.keys():
 
@@ -1 +1,3 @@
-rosrun stateviz 3dviz.py -f mockstate.txt & rosrun rviz rviz -d quadstate.rviz
+# Convert the text log once; the visualizer maps the result instead of parsing it
+[ mockstate.rftlog -nt mockstate.txt ] || ./statelog.py convert mockstate.txt mockstate.rftlog
+rosrun stateviz 3dviz.py -f mockstate.rftlog & rosrun rviz rviz -d quadstate.rviz
@@ -0,0 +1,324 @@
+#!/usr/bin/env python3
+'''
+Binary columnar state logs for the visualizers
+
+A log holds a fixed number of rows in typed columns, each stored contiguously,
+so that it can be memory-mapped and read in place: opening a log of any
+length costs the same, and any row is an index away.  Layout, little-endian:
+
+    header      magic 'RFTCOLS\\0', version (uint16), column count (uint16),
+                reserved (uint32), row count (uint64)
+    columns     per column: name (23 bytes, NUL-padded), struct type code
+                (1 byte: B, h, i, f or d), file offset of its data (uint64)
+    data        each column's values, starting on an eight-byte boundary
+
+A log from a converted text or MSP capture has a 'time' column in seconds
+and the columns the visualizers display: x, y, z and heading (degrees).
+
+    % ./statelog.py convert mockstate.txt mockstate.rftlog
+    % ./statelog.py info mockstate.rftlog
+
+Copyright (C) 2021 Simon D. Levy
+
+MIT License
+'''
+
+import argparse
+import array
+import bisect
+import json
+import math
+import mmap
+import os
+import struct
+import sys
+
+MAGIC = b'RFTCOLS\0'
+VERSION = 1
+
+_HEADER = struct.Struct('<8sHHIQ')
+_COLUMN = struct.Struct('<23scQ')
+
+# struct type code to array type code
+_TYPES = {'B': 'B', 'h': 'h', 'i': 'i', 'f': 'f', 'd': 'd'}
+
+# Column names for a four-column text log, as written by the visualizers
+TEXT_COLUMNS = ('x', 'y', 'z', 'heading')
+
+# messages.json type names to struct type codes
+_MSP_TYPES = {'byte': 'B', 'short': 'h', 'int': 'i', 'float': 'f'}
+
+_MESSAGES = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                         '..', 'parser', 'messages.json')
+
+
+def _align(offset):
+
+    return (offset + 7) & ~7
+
+
+def write(path, columns):
+    '''
+    Writes a log from a list of (name, type code, values) with equal numbers
+    of values
+    '''
+
+    rows = len(columns[0][2]) if columns else 0
+
+    offset = _HEADER.size + _COLUMN.size * len(columns)
+
+    descriptors = []
+
+    for name, code, values in columns:
+
+        if len(values) != rows:
+            raise ValueError('column %s has %d rows, not %d' %
+                             (name, len(values), rows))
+
+        offset = _align(offset)
+        descriptors.append((name, code, offset))
+        offset += struct.calcsize(code) * rows
+
+    with open(path, 'wb') as outfile:
+
+        outfile.write(_HEADER.pack(MAGIC, VERSION, len(columns), 0, rows))
+
+        for name, code, offset in descriptors:
+            outfile.write(_COLUMN.pack(name.encode(), code.encode(), offset))
+
+        for (name, code, values), (_, _, offset) in zip(columns, descriptors):
+
+            outfile.write(b'\0' * (offset - outfile.tell()))
+
+            data = array.array(_TYPES[code], values)
+            if sys.byteorder == 'big':
+                data.byteswap()
+            data.tofile(outfile)
+
+
+def is_log(path):
+
+    with open(path, 'rb') as infile:
+        return infile.read(len(MAGIC)) == MAGIC
+
+
+class StateLog(object):
+    '''
+    A memory-mapped log.  Columns are read-only sequences over the file, so
+    nothing is read until it is used.
+    '''
+
+    def __init__(self, path):
+
+        self.file = open(path, 'rb')
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+
+        magic, version, count, _, self.rows = _HEADER.unpack_from(self.map, 0)
+
+        if magic != MAGIC:
+            raise ValueError(path + ' is not a state log')
+
+        if version != VERSION:
+            raise ValueError('%s has version %d, not %d' %
+                             (path, version, VERSION))
+
+        self.names = []
+        self.types = {}
+        self.columns = {}
+
+        view = memoryview(self.map)
+        self.views = [view]
+
+        for k in range(count):
+
+            name, code, offset = _COLUMN.unpack_from(
+                    self.map, _HEADER.size + k * _COLUMN.size)
+
+            name = name.rstrip(b'\0').decode()
+            code = code.decode()
+            size = struct.calcsize(code)
+
+            data = view[offset:offset + size * self.rows]
+            self.views.append(data)
+
+            # In place when the host is little-endian, as nearly all are
+            if sys.byteorder == 'little':
+                data = data.cast(_TYPES[code])
+                self.views.append(data)
+            else:
+                data = array.array(_TYPES[code], data)
+                data.byteswap()
+
+            self.names.append(name)
+            self.types[name] = code
+            self.columns[name] = data
+
+    def __len__(self):
+
+        return self.rows
+
+    def __getitem__(self, name):
+
+        return self.columns[name]
+
+    def row(self, index):
+
+        return tuple(self.columns[name][index] for name in self.names)
+
+    def index(self, seconds):
+        '''
+        First row at or after the given time
+        '''
+
+        return bisect.bisect_left(self.columns['time'], seconds)
+
+    def duration(self):
+
+        time = self.columns['time']
+
+        return time[-1] - time[0] if self.rows > 0 else 0
+
+    def close(self):
+
+        # Columns become unusable, wherever they are held
+        for view in reversed(self.views):
+            view.release()
+        self.views = []
+        self.columns = {}
+        self.map.close()
+        self.file.close()
+
+
+def from_text(path, period, names=TEXT_COLUMNS):
+    '''
+    Columns from a whitespace-separated text log with one row per period
+    '''
+
+    values = array.array('d', map(float, open(path).read().split()))
+
+    count = len(names)
+    rows = len(values) // count
+
+    columns = [('time', 'd', [k * period for k in range(rows)])]
+
+    for j, name in enumerate(names):
+        columns.append((name, 'f', values[j:rows * count:count]))
+
+    return columns
+
+
+def from_msp(path, period, message='STATE', messages=_MESSAGES):
+    '''
+    Columns from a captured MSP byte stream: every field of each good
+    message of the given type, one row per period
+    '''
+
+    spec = json.load(open(messages))[message]
+
+    msgid = None
+    names = []
+    codes = []
+
+    for field in spec:
+        name, value = list(field.items())[0]
+        if name == 'ID':
+            msgid = value
+        elif name.lower() != 'comment':
+            names.append(name)
+            codes.append(_MSP_TYPES[value])
+
+    payload = struct.Struct('<' + ''.join(codes))
+
+    data = open(path, 'rb').read()
+
+    values = [[] for _ in names]
+
+    pos = 0
+
+    while True:
+
+        start = data.find(b'$M>', pos)
+
+        if start < 0 or start + 6 > len(data):
+            break
+
+        size = data[start+3]
+        stop = start + size + 6
+
+        if stop > len(data):
+            break
+
+        crc = 0
+        for c in data[start+3:stop]:
+            crc ^= c
+
+        if crc != 0:
+            pos = start + 1
+            continue
+
+        if data[start+4] == msgid and size == payload.size:
+            for column, value in zip(values, payload.unpack_from(data, start+5)):
+                column.append(value)
+
+        pos = stop
+
+    rows = len(values[0]) if values else 0
+
+    columns = [('time', 'd', [k * period for k in range(rows)])]
+    columns += list(zip(names, codes, values))
+
+    # Heading for the visualizers, from yaw in radians
+    if 'psi' in names and 'heading' not in names:
+        columns.append(('heading', 'f',
+                        [math.degrees(psi) for psi in values[names.index('psi')]]))
+
+    return columns
+
+
+def main():
+
+    argparser = argparse.ArgumentParser(description='Convert and inspect state logs')
+
+    subparsers = argparser.add_subparsers(dest='command')
+
+    convert = subparsers.add_parser('convert', help='convert a text log or MSP capture')
+    convert.add_argument('infile', help='text log, or captured MSP byte stream')
+    convert.add_argument('outfile', help='state log to write')
+    convert.add_argument('-p', '--period', type=float, default=0.01,
+                         help='seconds between rows')
+    convert.add_argument('-m', '--message', default='STATE',
+                         help='MSP message to extract from a capture')
+
+    info = subparsers.add_parser('info', help='describe a state log')
+    info.add_argument('logfile')
+
+    cmdargs = argparser.parse_args()
+
+    if cmdargs.command == 'convert':
+
+        with open(cmdargs.infile, 'rb') as infile:
+            msp = infile.read(2) == b'$M'
+
+        columns = (from_msp(cmdargs.infile, cmdargs.period, cmdargs.message)
+                   if msp else from_text(cmdargs.infile, cmdargs.period))
+
+        write(cmdargs.outfile, columns)
+
+    elif cmdargs.command == 'info':
+
+        log = StateLog(cmdargs.logfile)
+
+        print('%d rows, %.1f seconds' % (len(log), log.duration()))
+
+        for name in log.names:
+            print('    %-23s %s' % (name, log.types[name]))
+
+        log.close()
+
+    else:
+
+        argparser.print_help()
+
+
+if __name__ == '__main__':
+    main()
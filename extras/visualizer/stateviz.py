@@ -7,6 +7,7 @@ MIT License
 '''
 
 import msppg
+import statelog
 import argparse
 import sys
 import time
@@ -24,6 +25,9 @@ class _MyArgumentParser(argparse.ArgumentParser):
 
 _request = msppg.serialize_STATE_Request()
 
+# Largest read from a socket
+_CHUNK = 4096
+
 class _StateParser(msppg.Parser):
 
     def __init__(self, readfun, writefun, closefun, visualizer):
@@ -51,7 +55,14 @@ class _StateParser(msppg.Parser):
 
                 try:
 
-                    self.parse(self.readfun(1))
+                    # Whatever has arrived, rather than a byte at a time
+                    data = self.readfun()
+
+                    if not data:
+                        self.closefun()
+                        break
+
+                    self.parse(data)
 
                 except KeyboardInterrupt:
 
@@ -78,6 +89,30 @@ def _handle_infile(visualizer, cmdargs):
 
         time.sleep(DT_SEC)
 
+def _handle_logfile(visualizer, cmdargs):
+
+    # Mapped, not read: seeking costs nothing however long the log
+    log = statelog.StateLog(cmdargs.filename)
+
+    viz = visualizer(cmdargs, 'From log: ' + cmdargs.filename)
+
+    x, y, z, heading = (log[name] for name in statelog.TEXT_COLUMNS)
+
+    start = 0 if cmdargs.start is None else log.index(float(cmdargs.start))
+    stop = len(log) if cmdargs.stop is None else log.index(float(cmdargs.stop))
+    step = 1 if cmdargs.step is None else int(cmdargs.step)
+
+    for k in range(start, stop, step):
+
+        if not viz.display(x[k], y[k], z[k], heading[k]):
+            break
+
+        time.sleep(log['time'][k+step] - log['time'][k] if k+step < len(log) else 0)
+
+    log.close()
+
+    exit(0)
+
 def _handle_bluetooth(visualizer, cmdargs):
 
     try:
@@ -90,7 +125,7 @@ def _handle_bluetooth(visualizer, cmdargs):
 
     viz = visualizer(cmdargs, 'From bluetooth: ' + cmdargs.bluetooth, _open_outfile(cmdargs))
 
-    parser = _StateParser(sock.recv, sock.send, sock.close, viz)
+    parser = _StateParser(lambda: sock.recv(_CHUNK), sock.send, sock.close, viz)
 
     parser.begin()
 
@@ -105,7 +140,20 @@ def _handle_serial(visualizer, cmdargs):
 
     viz = visualizer(cmdargs, 'From serial: ' + cmdargs.serial, _open_outfile(cmdargs))
 
-    parser = _StateParser(port.read, port.write, port.close, viz)
+    parser = _StateParser(lambda: port.read(max(1, port.in_waiting)), port.write, port.close, viz)
+
+    parser.begin()
+
+def _handle_unix(visualizer, cmdargs):
+
+    import socket
+
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    sock.connect(cmdargs.unix)
+
+    viz = visualizer(cmdargs, 'From socket: ' + cmdargs.unix, _open_outfile(cmdargs))
+
+    parser = _StateParser(lambda: sock.recv(_CHUNK), sock.send, sock.close, viz)
 
     parser.begin()
 
@@ -113,10 +161,14 @@ def run(visualizer):
 
     parser = _MyArgumentParser(description='Visualize incoming vehicle-state messages.')
 
-    parser.add_argument('-f', '--filename',    help='read state data from file')
+    parser.add_argument('-f', '--filename',    help='read state data from file (text or state log)')
     parser.add_argument('-b', '--bluetooth',   help='read state data from Bluetooth device')
     parser.add_argument('-s', '--serial',      help='read state data from serial port')
+    parser.add_argument('-u', '--unix',        help='read state data from Unix-domain socket (SITL)')
     parser.add_argument('-z', '--zero_angle',  help='starting angle in degrees')
+    parser.add_argument('--start',             help='state log: start time in seconds')
+    parser.add_argument('--stop',              help='state log: stop time in seconds')
+    parser.add_argument('--step',              help='state log: show every Nth row')
 
     if len(sys.argv)==1:
         parser.print_help(sys.stderr)
@@ -125,8 +177,11 @@ def run(visualizer):
     cmdargs = parser.parse_args()
 
     # Filename only; read it
-    if cmdargs.serial is None and cmdargs.bluetooth is None and not cmdargs.filename is None:
-        _handle_infile(visualizer, cmdargs)
+    if cmdargs.serial is None and cmdargs.bluetooth is None and cmdargs.unix is None and not cmdargs.filename is None:
+        if statelog.is_log(cmdargs.filename):
+            _handle_logfile(visualizer, cmdargs)
+        else:
+            _handle_infile(visualizer, cmdargs)
 
     # Bluetooth
     if not cmdargs.bluetooth is None:
@@ -135,3 +190,7 @@ def run(visualizer):
     # Serial
     if not cmdargs.serial is None:
         _handle_serial(visualizer, cmdargs)
+
+    # Unix-domain socket
+    if not cmdargs.unix is None:
+        _handle_unix(visualizer, cmdargs)
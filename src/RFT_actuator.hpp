@@ -20,6 +20,14 @@ namespace rft {
 
             virtual void begin(void) { }
 
+            // Polled after begin() until it returns true, e.g. while ESCs
+            // wait out their arming sequence; run() is not called before
+            virtual bool ready(float time)
+            {
+                (void)time;
+                return true;
+            }
+
             virtual void runDisarmed(void) { }
 
             virtual void cut(void) { }
@@ -0,0 +1,107 @@
+/*
+   Attitude value type, filled once per tick from a quaternion filter
+
+   Caches the body-from-inertial rotation matrix, computed directly from the
+   quaternion without trig, so that frame conversions are single 3x3
+   multiplies.  Euler angles are computed only when asked for.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include "RFT_filters.hpp"
+
+namespace rft {
+
+    class Attitude {
+
+        private:
+
+            float _q[4] = {1, 0, 0, 0};
+
+            // Body-from-inertial rotation
+            Mat<3,3> _R = Mat<3,3>::identity();
+
+            float _euler[3] = {0, 0, 0};
+            bool _haveEuler = true;
+
+        public:
+
+            void update(const QuaternionFilter & filter)
+            {
+                update(filter.q1, filter.q2, filter.q3, filter.q4);
+            }
+
+            void update(float qw, float qx, float qy, float qz)
+            {
+                _q[0] = qw;
+                _q[1] = qx;
+                _q[2] = qy;
+                _q[3] = qz;
+
+                float xx = qx * qx;
+                float yy = qy * qy;
+                float zz = qz * qz;
+                float xy = qx * qy;
+                float xz = qx * qz;
+                float yz = qy * qz;
+                float wx = qw * qx;
+                float wy = qw * qy;
+                float wz = qw * qz;
+
+                _R(0,0) = 1 - 2 * (yy + zz);
+                _R(0,1) = 2 * (xy + wz);
+                _R(0,2) = 2 * (xz - wy);
+
+                _R(1,0) = 2 * (xy - wz);
+                _R(1,1) = 1 - 2 * (xx + zz);
+                _R(1,2) = 2 * (yz + wx);
+
+                _R(2,0) = 2 * (xz + wy);
+                _R(2,1) = 2 * (yz - wx);
+                _R(2,2) = 1 - 2 * (xx + yy);
+
+                _haveEuler = false;
+            }
+
+            const float * quaternion(void) const
+            {
+                return _q;
+            }
+
+            // Same angles as Filter::quat2euler()
+            const float * euler(void)
+            {
+                if (!_haveEuler) {
+                    Filter::quat2euler(_q[0], _q[1], _q[2], _q[3],
+                                       _euler[0], _euler[1], _euler[2]);
+                    _haveEuler = true;
+                }
+
+                return _euler;
+            }
+
+            // Because Filter::quat2euler() reports pitch with the opposite
+            // sign, these match Filter::inertial2body() and
+            // Filter::body2inertial() for rotation {phi, -theta, psi}
+            Vec<3> inertial2body(const Vec<3> & inertial) const
+            {
+                return _R * inertial;
+            }
+
+            Vec<3> body2inertial(const Vec<3> & body) const
+            {
+                return _R.transposeTimes(body);
+            }
+
+            const Mat<3,3> & rotation(void) const
+            {
+                return _R;
+            }
+
+    }; // class Attitude
+
+} // namespace rft
@@ -19,6 +19,8 @@ namespace rft {
         friend class Debugger;
         friend class TimerTask;
         friend class ClosedLoopTask;
+        friend class ParameterStore;
+        friend class Scheduler;
 
         protected:
 
@@ -27,9 +29,46 @@ namespace rft {
 
             // ----------------- For real boards -------------------------------
             virtual void begin(void) { }
+            virtual bool ready(float time) { (void)time; return true; }
+            virtual void showStartingStatus(void) { }
             virtual void showArmedStatus(bool armed) { (void)armed; }
             virtual void flashLed(bool shouldflash) { (void)shouldflash; }
 
+            // Reports a setup the vehicle cannot fly with; a board that can
+            // show the message halts here, and in any case the firmware
+            // never finishes starting
+            virtual void error(const char * errmsg) { (void)errmsg; }
+
+            // Boards with a spare hardware timer can call callback(context)
+            // every period seconds, independent of the main loop; returns
+            // false if not supported
+            virtual bool startTimer(float period,
+                                    void (*callback)(void *),
+                                    void * context)
+            {
+                (void)period;
+                (void)callback;
+                (void)context;
+                return false;
+            }
+
+            // Boards with nonvolatile storage (EEPROM, flash, a file) keep
+            // the ParameterStore image there, from its first byte; both
+            // return false if not supported or if size is too large
+            virtual bool storageRead(void * dst, uint16_t size)
+            {
+                (void)dst;
+                (void)size;
+                return false;
+            }
+
+            virtual bool storageWrite(const void * src, uint16_t size)
+            {
+                (void)src;
+                (void)size;
+                return false;
+            }
+
     }; // class Board
 
 } // namespace
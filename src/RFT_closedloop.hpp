@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #include "RFT_state.hpp"
 
 namespace rft {
@@ -25,6 +27,12 @@ namespace rft {
                 return false;
             }
 
+            // Called on the first tick, with inactive set if the open-loop
+            // controller is inactive (e.g., throttle down), then with it set
+            // whenever the controller becomes inactive and once more when it
+            // becomes active again.  This was called on every tick before;
+            // modifyDemands() still runs while inactive, so a controller that
+            // resets when inactive is reset again as the vehicle takes off.
             virtual void resetOnInactivity(bool inactive)
             { 
                 (void)inactive; 
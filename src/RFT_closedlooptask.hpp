@@ -1,6 +1,15 @@
 /*
    Timer task for closed-loop controllers
 
+   A controller added with a mode index runs whenever the open-loop
+   controller's mode index is at least that high, in the order the
+   controllers were added.  The list of controllers to run in each mode is
+   built as they are added, so a tick looks only at the controllers that run
+   and switches lists when the mode changes.
+
+   Define RFT_CLOSEDLOOP_MAX (default 16) and RFT_CLOSEDLOOP_MODES (default
+   8) to change the number of controllers and mode indices allowed.
+
    Copyright (c) 2021 Simon D. Levy
 
    MIT License
@@ -11,6 +20,17 @@
 #include "RFT_timertask.hpp"
 #include "RFT_state.hpp"
 #include "RFT_openloop.hpp"
+#include "RFT_closedloop.hpp"
+#include "RFT_actuator.hpp"
+#include "RFT_footprint.hpp"
+
+#ifndef RFT_CLOSEDLOOP_MAX
+#define RFT_CLOSEDLOOP_MAX 16
+#endif
+
+#ifndef RFT_CLOSEDLOOP_MODES
+#define RFT_CLOSEDLOOP_MODES 8
+#endif
 
 namespace rft {
 
@@ -18,11 +38,21 @@ namespace rft {
 
         friend class RFTPure;
 
+        public:
+
+            static const uint8_t MAX = RFT_CLOSEDLOOP_MAX;
+            static const uint8_t MODES = RFT_CLOSEDLOOP_MODES;
+
         private:
 
-            // PID controllers
-            ClosedLoopController * _controllers[256] = {};
-            uint8_t _controller_count = 0;
+            // The controllers to run in each mode, in the order added; the
+            // last list holds them all
+            ClosedLoopController * _lists[MODES][MAX] = {};
+            uint8_t _counts[MODES] = {};
+
+            // Whether the open-loop controller was inactive on the last
+            // tick; neither before the first
+            int8_t _inactive = -1;
 
         protected:
 
@@ -32,15 +62,35 @@ namespace rft {
             ClosedLoopTask(float freq=300)
                 : TimerTask(freq)
             {
-                _controller_count = 0;
             }
 
-            void addController(ClosedLoopController * controller,
+            // Returns false if there's no room, or the mode index is
+            // MODES or more
+            bool addController(ClosedLoopController * controller,
                                uint8_t modeIndex) 
             {
+                if (_counts[MODES-1] == MAX || modeIndex >= MODES) {
+                    return false;
+                }
+
                 controller->modeIndex = modeIndex;
 
-                _controllers[_controller_count++] = controller;
+                // Runs in its own mode and every higher one
+                for (uint8_t m=modeIndex; m<MODES; ++m) {
+                    _lists[m][_counts[m]++] = controller;
+                }
+
+                // A new controller hears about inactivity from the next tick
+                _inactive = -1;
+
+                return true;
+            }
+
+            void addFootprint(Footprint & footprint)
+            {
+                footprint.add("ClosedLoopTask", sizeof(*this), MAX,
+                        &_counts[MODES-1],
+                        MODES * sizeof(ClosedLoopController *));
             }
 
             void update(Board * board,
@@ -48,37 +98,58 @@ namespace rft {
                         Actuator * actuator,
                         State * state)
             {
-                if (!TimerTask::ready(board)) {
-                    return;
+                if (TimerTask::ready(board)) {
+                    run(board, olc, actuator, state);
                 }
+            }
 
+            // One tick, whenever a Scheduler releases it; cut, if given,
+            // is set from a timer to stop the motors, and is checked right
+            // before they're run
+            void run(Board * board,
+                     OpenLoopController * olc,
+                     Actuator * actuator,
+                     State * state,
+                     const volatile bool * cut=NULL)
+            {
                 // Start with demands from open-loop controller
                 float demands[OpenLoopController::MAX_DEMANDS] = {};
                 olc->getDemands(demands);
 
+                bool inactive = olc->inactive();
+
+                // Some controllers need to be reset based on inactivity
+                // (e.g., throttle down resets PID controller integral); all
+                // of them hear when it starts, and again, as inactive, when
+                // it ends, so that one resetting on inactive takes off clean
+                if (inactive != _inactive) {
+
+                    bool reset = inactive || _inactive == 1;
+
+                    _inactive = inactive;
+
+                    for (uint8_t k=0; k<_counts[MODES-1]; ++k) {
+                        _lists[MODES-1][k]->resetOnInactivity(reset);
+                    }
+                }
+
                 // Each controller is associated with at least one auxiliary
-                // switch state
+                // switch state; modes above the last run all the controllers
                 uint8_t modeIndex = olc->getModeIndex();
+                uint8_t mode = modeIndex < MODES ? modeIndex : MODES-1;
+
+                ClosedLoopController ** controllers = _lists[mode];
 
                 // Some controllers should cause LED to flash when they're
                 // active
                 bool shouldFlash = false;
 
-                for (uint8_t k=0; k<_controller_count; ++k) {
-
-                    ClosedLoopController * controller = _controllers[k];
-
-                    // Some controllers need to be reset based on inactivty
-                    // (e.g., throttle down resets PID controller integral)
-                    controller->resetOnInactivity(olc->inactive());
-
-                    if (controller->modeIndex <= modeIndex) {
+                for (uint8_t k=0; k<_counts[mode]; ++k) {
 
-                        controller->modifyDemands(state, demands); 
+                    controllers[k]->modifyDemands(state, demands); 
 
-                        if (controller->shouldFlashLed()) {
-                            shouldFlash = true;
-                        }
+                    if (controllers[k]->shouldFlashLed()) {
+                        shouldFlash = true;
                     }
                 }
 
@@ -89,11 +160,11 @@ namespace rft {
                 // actuator to choose whether it cares about
                 // open-loop controller being inactive (e.g.,
                 // throttle down)
-                if (!state->failsafe) {
-                    actuator->run(demands, state->armed && !olc->inactive());
+                if (!state->failsafe && !(cut && *cut)) {
+                    actuator->run(demands, state->armed && !inactive);
                 }
 
-             } // doTask
+             } // run
 
     };  // ClosedLoopTask
 
@@ -5,6 +5,21 @@
     debug messages.  Your Board implementation should provide and outbuf(char
     method that displays the message in an appropriate way.
 
+    Messages go into a ring buffer rather than straight to outbuf(), and
+    drain() passes at most a given number of bytes along, so a print never
+    waits on the port.  SerialTask drains the buffer as the port has room; a
+    sketch without one can call drain() from its loop.  When the buffer is
+    full, new text is dropped unless setOverflowPolicy(DROP_OLDEST) is called,
+    and dropped() counts the lost bytes.  Define RFT_DEBUG_BUFSIZE (a power of
+    two, default 512) to change the size of the buffer.
+
+    printf() still formats on the spot, so avoid it inside the control loop;
+    use RFT_LOG() from RFT_logger.hpp there instead.
+
+    As with RFT_LOG(), each RFTPure keeps its own buffer and selects it for
+    the calling thread, so firmware objects on different threads don't
+    share one; outbuf() is still the one port of the board.
+
     Copyright (c) 2021 Simon D. Levy
 
     MIT License
@@ -13,7 +28,17 @@
 #pragma once
 
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+
+#include "RFT_footprint.hpp"
+#include "RFT_logger.hpp" // RFT_THREAD_LOCAL
+
+#ifndef RFT_DEBUG_BUFSIZE
+#define RFT_DEBUG_BUFSIZE 512
+#endif
 
 namespace rft {
 
@@ -21,16 +46,144 @@ namespace rft {
 
         public:
 
+            typedef enum {
+
+                DROP_NEWEST,
+                DROP_OLDEST
+
+            } overflow_policy_t;
+
+            // Constant-initialized, so no guard on first use
+            struct Ring {
+                char buf[RFT_DEBUG_BUFSIZE];
+                uint16_t head;
+                uint16_t tail;
+                uint32_t dropped;
+                overflow_policy_t policy;
+                uint16_t highWater;
+            };
+
+        private:
+
+            static const uint16_t MASK = RFT_DEBUG_BUFSIZE - 1;
+
+            static_assert((RFT_DEBUG_BUFSIZE & MASK) == 0,
+                    "RFT_DEBUG_BUFSIZE must be a power of two");
+
+            static Ring *& selected(void)
+            {
+                static RFT_THREAD_LOCAL Ring * r = NULL;
+                return r;
+            }
+
+            static Ring & ring(void)
+            {
+                static Ring unselected;
+                Ring * r = selected();
+                return r ? *r : unselected;
+            }
+
+            static void push(const char * msg)
+            {
+                Ring & r = ring();
+
+                uint16_t len = strlen(msg);
+                uint16_t used = r.head - r.tail;
+
+                if (len > RFT_DEBUG_BUFSIZE - used) {
+
+                    // Keep what is already queued
+                    if (r.policy == DROP_NEWEST) {
+                        r.dropped += len;
+                        return;
+                    }
+
+                    // Keep only the end of a message longer than the buffer
+                    if (len > RFT_DEBUG_BUFSIZE) {
+                        r.dropped += len - RFT_DEBUG_BUFSIZE;
+                        msg += len - RFT_DEBUG_BUFSIZE;
+                        len = RFT_DEBUG_BUFSIZE;
+                    }
+
+                    uint16_t excess = len - (RFT_DEBUG_BUFSIZE - used);
+                    r.tail += excess;
+                    r.dropped += excess;
+                }
+
+                for (uint16_t k=0; k<len; ++k) {
+                    r.buf[r.head++ & MASK] = msg[k];
+                }
+
+                used = r.head - r.tail;
+                r.highWater = used > r.highWater ? used : r.highWater;
+            }
+
+        public:
+
+            // Sends this thread's messages to ring from now on
+            static void select(Ring & ring)
+            {
+                selected() = &ring;
+            }
+
             static void printf(const char * fmt, ...)
             {
                 va_list ap;
                 va_start(ap, fmt);
                 char buf[200];
                 vsnprintf(buf, 200, fmt, ap); 
-                outbuf(buf);
+                push(buf);
                 va_end(ap);
             }
 
+            // Sends up to budget buffered bytes to outbuf(); returns the
+            // number sent
+            static uint16_t drain(uint16_t budget=RFT_DEBUG_BUFSIZE)
+            {
+                Ring & r = ring();
+
+                uint16_t sent = 0;
+
+                while (sent < budget && r.tail != r.head) {
+
+                    char chunk[33];
+                    uint8_t n = 0;
+
+                    while (n < sizeof(chunk)-1 && sent < budget &&
+                            r.tail != r.head) {
+                        chunk[n++] = r.buf[r.tail++ & MASK];
+                        sent++;
+                    }
+
+                    chunk[n] = 0;
+                    outbuf(chunk);
+                }
+
+                return sent;
+            }
+
+            static uint16_t pending(void)
+            {
+                return ring().head - ring().tail;
+            }
+
+            // Bytes lost to overflow
+            static uint32_t dropped(void)
+            {
+                return ring().dropped;
+            }
+
+            static void setOverflowPolicy(overflow_policy_t policy)
+            {
+                ring().policy = policy;
+            }
+
+            static void addFootprint(Footprint & footprint)
+            {
+                footprint.add("Debugger", sizeof(Ring), RFT_DEBUG_BUFSIZE,
+                        &ring().highWater);
+            }
+
             // for boards that do not support floating-point vnsprintf
             static void printfloat(float val, uint8_t prec=3)
             {
@@ -0,0 +1,292 @@
+/*
+   Decimation of high-rate sensor samples, e.g. an 8 kHz gyro, down to the
+   rate the filters and controllers run at
+
+   Each axis goes through a cascaded integrator-comb (CIC) filter, which
+   decimates by CIC_RATIO using only integer additions on the raw samples,
+   then through a symmetric FIR filter at the lower rate, which flattens the
+   CIC's passband droop, removes what would alias into the passband, and
+   decimates by FIR_RATIO.  Call update() with every raw sample from the
+   sensor; it returns true, with the filtered values, once every
+   CIC_RATIO * FIR_RATIO samples:
+
+       static Decimator<3> gyroDecimator(GYRO_LSB);  // 8 kHz in, 500 Hz out
+
+       int16_t raw[3] = ...;
+       float rates[3];
+       if (gyroDecimator.update(raw, rates)) {
+           // feed rates to the quaternion filter
+       }
+
+   SimImu::readGyrometer() shows one run from a sensor's sample path.
+
+   The integrators wrap around in 32 bits, which the combs undo exactly, so
+   ORDER * log2(CIC_RATIO) may be at most 16 for 16-bit samples.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+namespace rft {
+
+    // Ceiling of log2(N), for checking the integrators' bit growth
+    template <uint32_t N> struct DecimatorLog2 {
+
+        static const uint8_t value = 1 + DecimatorLog2<(N+1)/2>::value;
+    };
+
+    template <> struct DecimatorLog2<1> {
+
+        static const uint8_t value = 0;
+    };
+
+    template <uint8_t AXES=3, uint8_t ORDER=3, uint8_t CIC_RATIO=8,
+              uint8_t FIR_RATIO=2, uint8_t TAPS=31>
+    class Decimator {
+
+        static_assert(ORDER >= 1 && CIC_RATIO >= 1 && FIR_RATIO >= 1,
+                "order and ratios must be positive");
+
+        static_assert(ORDER * DecimatorLog2<CIC_RATIO>::value <= 16,
+                "CIC output would overflow 32 bits");
+
+        static_assert(TAPS % 2 == 1 && TAPS <= 127,
+                "FIR must have an odd number of taps, at most 127");
+
+        public:
+
+            // Input samples per output
+            static const uint16_t RATIO = CIC_RATIO * FIR_RATIO;
+
+        private:
+
+            static const uint8_t HALF = TAPS / 2;
+
+            // Converts CIC output, in counts times CIC_RATIO^ORDER, to
+            // input units
+            float _scale = 0;
+
+            // Inverse of the input units per count, for float input
+            float _perCount = 0;
+
+            uint32_t _integrators[AXES][ORDER] = {};
+            uint32_t _combs[AXES][ORDER] = {};
+            uint8_t _cicPhase = 0;
+
+            // CIC outputs, each stored twice so that the last TAPS are
+            // always contiguous at _history[axis][_head]
+            float _history[AXES][2*TAPS] = {};
+            uint8_t _head = 0;
+            uint8_t _firPhase = 0;
+
+            // Center tap last; the others apply to pairs of samples
+            float _taps[HALF+1] = {};
+
+            // CIC magnitude response at f cycles per CIC output sample
+            static float cicResponse(float f)
+            {
+                if (f < 1e-6f) {
+                    return 1;
+                }
+
+                float x = (float)M_PI * f;
+                float h = sinf(x) / (CIC_RATIO * sinf(x / CIC_RATIO));
+
+                float response = 1;
+                for (uint8_t k=0; k<ORDER; ++k) {
+                    response *= h;
+                }
+
+                return fabsf(response);
+            }
+
+            // Windowed frequency-sampling design: the inverse of the CIC
+            // response up to the passband edge, tapering to zero at the
+            // first frequency that aliases into the passband after the
+            // final decimation
+            void design(float passband)
+            {
+                float pass = 0.5f * passband / FIR_RATIO;
+                float stop = 1.0f / FIR_RATIO - pass;
+                stop = stop > 0.5f ? 0.5f : stop;
+
+                static const uint16_t POINTS = 512;
+
+                float sum = 0;
+
+                for (uint8_t n=0; n<=HALF; ++n) {
+
+                    float h = 0;
+
+                    for (uint16_t k=0; k<POINTS; ++k) {
+
+                        float f = (k + 0.5f) * 0.5f / POINTS;
+
+                        float d = f <= pass ? 1 / cicResponse(f)
+                            : f < stop ? (stop - f) / (stop - pass) /
+                            cicResponse(f)
+                            : 0;
+
+                        h += d * cosf(2 * (float)M_PI * f * n);
+                    }
+
+                    h /= POINTS;
+
+                    // Hamming window
+                    float w = 0.54f + 0.46f * cosf((float)M_PI * n / (HALF+1));
+
+                    // Center tap (n=0) goes last
+                    _taps[n == 0 ? HALF : n-1] = h * w;
+
+                    sum += n == 0 ? h * w : 2 * h * w;
+                }
+
+                // Unity gain at DC
+                for (uint8_t k=0; k<=HALF; ++k) {
+                    _taps[k] /= sum;
+                }
+            }
+
+            bool filter(const int32_t * cic, float * out)
+            {
+                for (uint8_t a=0; a<AXES; ++a) {
+                    float x = cic[a] * _scale;
+                    _history[a][_head] = x;
+                    _history[a][_head + TAPS] = x;
+                }
+
+                _head = _head == 0 ? TAPS-1 : _head-1;
+
+                if (++_firPhase < FIR_RATIO) {
+                    return false;
+                }
+
+                _firPhase = 0;
+
+                for (uint8_t a=0; a<AXES; ++a) {
+
+                    // Newest sample first
+                    const float * x = &_history[a][_head + 1];
+
+                    float y = _taps[HALF] * x[HALF];
+
+                    for (uint8_t k=0; k<HALF; ++k) {
+                        y += _taps[k] * (x[HALF-1-k] + x[HALF+1+k]);
+                    }
+
+                    out[a] = y;
+                }
+
+                return true;
+            }
+
+        public:
+
+            // lsb: input units (e.g. rad/s) per count; passband: fraction of
+            // the output Nyquist frequency kept flat
+            Decimator(float lsb, float passband=0.5)
+            {
+                float gain = 1;
+                for (uint8_t k=0; k<ORDER; ++k) {
+                    gain *= CIC_RATIO;
+                }
+
+                _scale = lsb / gain;
+                _perCount = 1 / lsb;
+
+                design(passband);
+            }
+
+            void begin(void)
+            {
+                for (uint8_t a=0; a<AXES; ++a) {
+                    for (uint8_t s=0; s<ORDER; ++s) {
+                        _integrators[a][s] = 0;
+                        _combs[a][s] = 0;
+                    }
+                    for (uint8_t k=0; k<2*TAPS; ++k) {
+                        _history[a][k] = 0;
+                    }
+                }
+
+                _cicPhase = 0;
+                _firPhase = 0;
+                _head = 0;
+            }
+
+            // Raw counts for each axis; returns true when out[] has new
+            // values
+            bool update(const int16_t * raw, float * out)
+            {
+                for (uint8_t a=0; a<AXES; ++a) {
+
+                    uint32_t x = (uint32_t)(int32_t)raw[a];
+
+                    for (uint8_t s=0; s<ORDER; ++s) {
+                        _integrators[a][s] += x;
+                        x = _integrators[a][s];
+                    }
+                }
+
+                if (++_cicPhase < CIC_RATIO) {
+                    return false;
+                }
+
+                _cicPhase = 0;
+
+                int32_t cic[AXES];
+
+                for (uint8_t a=0; a<AXES; ++a) {
+
+                    uint32_t y = _integrators[a][ORDER-1];
+
+                    for (uint8_t s=0; s<ORDER; ++s) {
+                        uint32_t previous = _combs[a][s];
+                        _combs[a][s] = y;
+                        y -= previous;
+                    }
+
+                    cic[a] = (int32_t)y;
+                }
+
+                return filter(cic, out);
+            }
+
+            // Values in input units, quantized to counts first
+            bool update(const float * values, float * out)
+            {
+                int16_t raw[AXES];
+
+                for (uint8_t a=0; a<AXES; ++a) {
+                    // Rounded to nearest
+                    float counts = values[a] * _perCount;
+                    counts += counts < 0 ? -0.5f : 0.5f;
+                    raw[a] = counts > 32767 ? 32767 : counts < -32768 ? -32768
+                        : (int16_t)counts;
+                }
+
+                return update(raw, out);
+            }
+
+            // Gain of the whole chain at f Hz, for an input rate of rate Hz
+            float response(float f, float rate)
+            {
+                float fcic = f * CIC_RATIO / rate;
+
+                float h = _taps[HALF];
+                for (uint8_t k=0; k<HALF; ++k) {
+                    h += 2 * _taps[k] * cosf(2 * (float)M_PI * fcic * (k+1));
+                }
+
+                return fabsf(h) * cicResponse(fcic);
+            }
+
+    }; // class Decimator
+
+} // namespace rft
@@ -0,0 +1,277 @@
+/*
+   Dynamic notch filters that track motor vibration in gyro data
+
+   Each axis of the gyro passes through NOTCHES biquad notch filters whose
+   center frequencies follow the strongest narrow-band peaks of that axis's
+   spectrum.  The spectrum comes from a real FFT over the last N raw samples;
+   one axis is analyzed at a time and the work is spread over STEPS calls to
+   update(), one FFT stage per call, so the cost of any one tick stays small:
+
+       static DynamicNotch<> notch(1000, 80, 450);  // 1 kHz gyro
+
+       float gyro[3] = ...;
+       notch.update(gyro);  // filtered in place
+
+   A peak counts only if it lies between minHz and maxHz and stands well
+   above the median power of that band, which a strong fundamental does not
+   raise the way it would the mean; a notch with no peak to follow is
+   switched off until one appears.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+#include "RFT_filters.hpp"
+#include "RFT_fft.hpp"
+
+namespace rft {
+
+    template <uint16_t N=64, uint8_t NOTCHES=2>
+    class DynamicNotch {
+
+        static_assert(NOTCHES >= 1, "need at least one notch per axis");
+
+        public:
+
+            // Calls to update() per full analysis of one axis: windowing,
+            // each FFT stage, the spectrum, and the peak search
+            static const uint8_t STEPS = RealFft<N>::STAGES + 3;
+
+        private:
+
+            static const uint16_t BINS = RealFft<N>::BINS;
+
+            // A peak must be this many times the band's median power
+            static constexpr float THRESHOLD = 10;
+
+            // Fraction of the way each center moves toward a new peak
+            static constexpr float SMOOTHING = 0.5f;
+
+            float _rate = 0;
+            float _q = 0;
+
+            uint16_t _minBin = 0;
+            uint16_t _maxBin = 0;
+
+            // Last N raw samples of each axis
+            float _samples[3][N] = {};
+            uint16_t _head = 0;
+
+            float _window[N] = {};
+            float _windowed[N] = {};
+            float _power[BINS] = {};
+            float _sorted[BINS] = {};
+
+            RealFft<N> _fft;
+
+            uint8_t _axis = 0;
+            uint8_t _step = 0;
+
+            BiquadFilter _notches[3][NOTCHES];
+            float _centers[3][NOTCHES] = {};
+            bool _active[3][NOTCHES] = {};
+
+            void load(void)
+            {
+                // Oldest sample first
+                for (uint16_t k=0; k<N; ++k) {
+                    _windowed[k] = _window[k] * _samples[_axis][(_head + k) % N];
+                }
+
+                _fft.load(_windowed);
+            }
+
+            // Strongest local maxima, interpolated to fractional bins and
+            // returned in increasing frequency
+            uint8_t findPeaks(float * peaks)
+            {
+                // Insertion sort of the band, for its median
+                uint16_t size = _maxBin - _minBin + 1;
+                for (uint16_t j=0; j<size; ++j) {
+                    float p = _power[_minBin + j];
+                    uint16_t i = j;
+                    for (; i>0 && _sorted[i-1] > p; --i) {
+                        _sorted[i] = _sorted[i-1];
+                    }
+                    _sorted[i] = p;
+                }
+                float least = THRESHOLD * _sorted[size/2];
+
+                float heights[NOTCHES] = {};
+                uint8_t count = 0;
+
+                for (uint16_t k=_minBin; k<=_maxBin; ++k) {
+
+                    float p = _power[k];
+
+                    if (p <= least || p <= _power[k-1] ||
+                            p < _power[k+1]) {
+                        continue;
+                    }
+
+                    // Replace the weakest if full
+                    uint8_t slot = count;
+                    if (count == NOTCHES) {
+                        slot = 0;
+                        for (uint8_t j=1; j<NOTCHES; ++j) {
+                            if (heights[j] < heights[slot]) {
+                                slot = j;
+                            }
+                        }
+                        if (heights[slot] >= p) {
+                            continue;
+                        }
+                    }
+                    else {
+                        count++;
+                    }
+
+                    float a = _power[k-1];
+                    float c = _power[k+1];
+                    float d = a - 2 * p + c;
+
+                    heights[slot] = p;
+                    peaks[slot] = k + (d < 0 ? 0.5f * (a - c) / d : 0);
+                }
+
+                // Insertion sort by frequency
+                for (uint8_t j=1; j<count; ++j) {
+                    float f = peaks[j];
+                    uint8_t i = j;
+                    for (; i>0 && peaks[i-1] > f; --i) {
+                        peaks[i] = peaks[i-1];
+                    }
+                    peaks[i] = f;
+                }
+
+                return count;
+            }
+
+            void retune(void)
+            {
+                float peaks[NOTCHES] = {};
+                uint8_t count = findPeaks(peaks);
+
+                for (uint8_t j=0; j<NOTCHES; ++j) {
+
+                    if (j >= count) {
+                        _active[_axis][j] = false;
+                        continue;
+                    }
+
+                    float freq = peaks[j] * _rate / N;
+
+                    float & center = _centers[_axis][j];
+
+                    if (_active[_axis][j]) {
+                        center += SMOOTHING * (freq - center);
+                    }
+                    else {
+                        // Starting from rest rather than mid-ring
+                        center = freq;
+                        _notches[_axis][j].begin();
+                        _active[_axis][j] = true;
+                    }
+
+                    _notches[_axis][j].setNotch(center, _rate, _q);
+                }
+            }
+
+            void analyze(void)
+            {
+                if (_step == 0) {
+                    load();
+                }
+                else if (_step <= RealFft<N>::STAGES) {
+                    _fft.stage(_step - 1);
+                }
+                else if (_step == RealFft<N>::STAGES + 1) {
+                    _fft.finish(_power);
+                }
+                else {
+                    retune();
+                }
+
+                if (++_step == STEPS) {
+                    _step = 0;
+                    _axis = (_axis + 1) % 3;
+                }
+            }
+
+        public:
+
+            // rate: gyro samples per second; minHz, maxHz: range searched
+            // for peaks; q: center frequency over notch bandwidth
+            DynamicNotch(float rate, float minHz, float maxHz, float q=3)
+            {
+                _rate = rate;
+                _q = q;
+
+                float binHz = rate / N;
+
+                // Leave a neighbor on each side for the local-maximum test
+                _minBin = (uint16_t)(minHz / binHz + 0.5f);
+                _minBin = _minBin < 1 ? 1 : _minBin;
+                _maxBin = (uint16_t)(maxHz / binHz + 0.5f);
+                _maxBin = _maxBin > BINS-2 ? BINS-2 : _maxBin;
+                _maxBin = _maxBin < _minBin ? _minBin : _maxBin;
+
+                // Hann window
+                for (uint16_t k=0; k<N; ++k) {
+                    _window[k] = 0.5f - 0.5f * cosf(2 * (float)M_PI * k / N);
+                }
+            }
+
+            void begin(void)
+            {
+                for (uint8_t a=0; a<3; ++a) {
+                    for (uint16_t k=0; k<N; ++k) {
+                        _samples[a][k] = 0;
+                    }
+                    for (uint8_t j=0; j<NOTCHES; ++j) {
+                        _active[a][j] = false;
+                        _notches[a][j].begin();
+                    }
+                }
+
+                _head = 0;
+                _axis = 0;
+                _step = 0;
+            }
+
+            // Filters the three axes in place and advances the analysis by
+            // one step
+            void update(float * gyro)
+            {
+                for (uint8_t a=0; a<3; ++a) {
+
+                    // The analysis sees the signal before the notches
+                    _samples[a][_head] = gyro[a];
+
+                    for (uint8_t j=0; j<NOTCHES; ++j) {
+                        if (_active[a][j]) {
+                            gyro[a] = _notches[a][j].update(gyro[a]);
+                        }
+                    }
+                }
+
+                _head = (_head + 1) % N;
+
+                analyze();
+            }
+
+            // Center frequency in Hz of a notch, or zero if it is off
+            float center(uint8_t axis, uint8_t notch)
+            {
+                return _active[axis][notch] ? _centers[axis][notch] : 0;
+            }
+
+    }; // class DynamicNotch
+
+} // namespace rft
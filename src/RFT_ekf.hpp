@@ -0,0 +1,184 @@
+/*
+   Heap-free Extended Kalman Filter with sequential scalar updates
+
+   The state dimension N and the depth D of the delayed-measurement history
+   are template parameters, so the memory footprint is fixed at compile time.
+   Each measurement is a scalar, so the update needs no matrix inversion.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include "RFT_linalg.hpp"
+
+namespace rft {
+
+    // A scalar measurement model z = h(x)
+    template <uint8_t N> class EkfMeasurement {
+
+        public:
+
+            // Returns h(x) and sets H to its Jacobian at x
+            virtual float predict(const Vec<N> & x, Vec<N> & H) = 0;
+
+    }; // class EkfMeasurement
+
+    template <uint8_t N, uint8_t D=0> class ExtendedKalmanFilter {
+
+        private:
+
+            static const uint8_t HISTORY = D > 0 ? D : 1;
+
+            // Past states, for measurements that arrive late
+            Vec<N> _history[HISTORY];
+            float _historyTimes[HISTORY] = {};
+            uint8_t _historyIdx = 0;
+            uint8_t _historyCount = 0;
+
+            float _time = 0;
+
+            void correct(const Vec<N> & PH, float S, float innovation)
+            {
+                // Gain K = PH / S; x += K * innovation; P -= K * PH'
+                float gain = innovation / S;
+
+                for (uint8_t j=0; j<N; ++j) {
+
+                    _x[j] += PH[j] * gain;
+
+                    for (uint8_t k=0; k<=j; ++k) {
+                        _P(j,k) -= PH[j] * PH[k] / S;
+                    }
+                }
+
+                // Keep the history consistent with the corrected estimate
+                for (uint8_t h=0; h<_historyCount; ++h) {
+                    for (uint8_t j=0; j<N; ++j) {
+                        _history[h][j] += PH[j] * gain;
+                    }
+                }
+            }
+
+        protected:
+
+            Vec<N> _x = Vec<N>::zeros();
+
+            SymMat<N> _P = SymMat<N>::zeros();
+
+            // Propagates _x over dt and returns the Jacobian F and process
+            // noise Q of the transition
+            virtual void transition(float dt, Mat<N,N> & F, SymMat<N> & Q) = 0;
+
+        public:
+
+            void predict(float dt)
+            {
+                Mat<N,N> F = Mat<N,N>::identity();
+                SymMat<N> Q = SymMat<N>::zeros();
+
+                transition(dt, F, Q);
+
+                // P = F P F' + Q, using the symmetry of P
+                Mat<N,N> FP;
+                for (uint8_t j=0; j<N; ++j) {
+                    for (uint8_t k=0; k<N; ++k) {
+                        float sum = 0;
+                        for (uint8_t l=0; l<N; ++l) {
+                            sum += F(j,l) * _P(l,k);
+                        }
+                        FP(j,k) = sum;
+                    }
+                }
+
+                for (uint8_t j=0; j<N; ++j) {
+                    for (uint8_t k=0; k<=j; ++k) {
+                        float sum = Q(j,k);
+                        for (uint8_t l=0; l<N; ++l) {
+                            sum += FP(j,l) * F(k,l);
+                        }
+                        _P(j,k) = sum;
+                    }
+                }
+
+                _time += dt;
+
+                if (D > 0) {
+                    _history[_historyIdx] = _x;
+                    _historyTimes[_historyIdx] = _time;
+                    _historyIdx = (_historyIdx + 1) % HISTORY;
+                    if (_historyCount < HISTORY) {
+                        _historyCount++;
+                    }
+                }
+            }
+
+            // Fuses measurement z with variance r; returns false if the
+            // innovation covariance is degenerate
+            bool update(EkfMeasurement<N> & measurement, float z, float r)
+            {
+                Vec<N> H;
+                float innovation = z - measurement.predict(_x, H);
+
+                Vec<N> PH = _P * H;
+                float S = H.dot(PH) + r;
+
+                if (S <= 0) {
+                    return false;
+                }
+
+                correct(PH, S, innovation);
+
+                return true;
+            }
+
+            // Fuses a measurement taken delay seconds ago, evaluating h
+            // against the stored state nearest that time.  Falls back to
+            // update() when D is zero or no history is available.
+            bool updateDelayed(EkfMeasurement<N> & measurement,
+                               float z, float r, float delay)
+            {
+                if (_historyCount == 0) {
+                    return update(measurement, z, r);
+                }
+
+                float when = _time - delay;
+                uint8_t best = 0;
+                for (uint8_t h=1; h<_historyCount; ++h) {
+                    float a = _historyTimes[h] - when;
+                    float b = _historyTimes[best] - when;
+                    if (a*a < b*b) {
+                        best = h;
+                    }
+                }
+
+                Vec<N> H;
+                float innovation = z - measurement.predict(_history[best], H);
+
+                Vec<N> PH = _P * H;
+                float S = H.dot(PH) + r;
+
+                if (S <= 0) {
+                    return false;
+                }
+
+                correct(PH, S, innovation);
+
+                return true;
+            }
+
+            const Vec<N> & state(void) const
+            {
+                return _x;
+            }
+
+            const SymMat<N> & covariance(void) const
+            {
+                return _P;
+            }
+
+    }; // class ExtendedKalmanFilter
+
+} // namespace rft
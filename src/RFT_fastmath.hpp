@@ -0,0 +1,252 @@
+/*
+   Compile-time-selectable approximations for trig and normalization
+
+   Select a tier by defining RFT_FASTMATH before including any RFT header:
+
+     0 (default): libm, full single precision
+
+     1: polynomial, max abs error 2.0e-6 rad (atan2, asin), 4.0e-6
+        (sin, cos); max relative error 5.0e-6 (invSqrt)
+
+     2: coarse polynomial, max abs error 1.5e-3 rad (atan2, asin), 1.6e-4
+        (sin, cos); max relative error 1.8e-3 (invSqrt)
+
+   Errors are measured by extras/benchmarks/fastmath.cpp.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef RFT_FASTMATH
+#define RFT_FASTMATH 0
+#endif
+
+namespace rft {
+
+    template <uint8_t TIER> class FastMathTier;
+
+    // Tier 0: libm -----------------------------------------------------------
+
+    template <> class FastMathTier<0> {
+
+        public:
+
+            static float atan2(float y, float x)
+            {
+                return atan2f(y, x);
+            }
+
+            static float asin(float x)
+            {
+                return asinf(x);
+            }
+
+            static void sincos(float x, float & s, float & c)
+            {
+                s = sinf(x);
+                c = cosf(x);
+            }
+
+            static float invSqrt(float x)
+            {
+                return 1.0f / sqrtf(x);
+            }
+
+    }; // class FastMathTier<0>
+
+    // Helpers shared by the approximating tiers ------------------------------
+
+    class FastMathPoly {
+
+        private:
+
+            static constexpr float PI_F   = 3.14159265f;
+            static constexpr float TWOPI  = 6.28318531f;
+            static constexpr float HALFPI = 1.57079633f;
+
+        public:
+
+            // Reduces x to [-pi/2, +pi/2], returning the sign to apply to the
+            // cosine (sine is unchanged by the reflection)
+            static float reduce(float & x)
+            {
+                x -= TWOPI * floorf((x + PI_F) / TWOPI);
+
+                if (x > HALFPI) {
+                    x = PI_F - x;
+                    return -1;
+                }
+
+                if (x < -HALFPI) {
+                    x = -PI_F - x;
+                    return -1;
+                }
+
+                return +1;
+            }
+
+            // Maps atan over [0,1] onto all four quadrants
+            template <typename ATAN>
+            static float atan2(float y, float x)
+            {
+                float ax = fabsf(x);
+                float ay = fabsf(y);
+
+                if (ax == 0 && ay == 0) {
+                    return 0;
+                }
+
+                bool swap = ay > ax;
+                float t = swap ? ax / ay : ay / ax;
+                float a = ATAN::atan01(t);
+
+                a = swap ? HALFPI - a : a;
+                a = x < 0 ? PI_F - a : a;
+
+                return y < 0 ? -a : a;
+            }
+
+            template <typename ATAN>
+            static float asin(float x)
+            {
+                x = x > 1 ? 1 : (x < -1 ? -1 : x);
+                return atan2<ATAN>(x, sqrtf(1 - x*x));
+            }
+
+            // Fast inverse square root with n Newton-Raphson iterations
+            static float invSqrt(float x, uint8_t n)
+            {
+                float halfx = 0.5f * x;
+                uint32_t i = 0;
+                memcpy(&i, &x, 4);
+                i = 0x5f375a86 - (i >> 1);
+                float y = 0;
+                memcpy(&y, &i, 4);
+                for (uint8_t k=0; k<n; ++k) {
+                    y = y * (1.5f - halfx * y * y);
+                }
+                return y;
+            }
+
+    }; // class FastMathPoly
+
+    // Tier 1: 11th-order atan, 9th/10th-order sin/cos, two Newton steps -----
+
+    template <> class FastMathTier<1> {
+
+        friend class FastMathPoly;
+
+        private:
+
+            static float atan01(float t)
+            {
+                float t2 = t * t;
+                return t * (0.99997726f + t2 * (-0.33262347f + t2 *
+                           (0.19354346f + t2 * (-0.11643287f + t2 *
+                           (0.05265332f + t2 * -0.01172120f)))));
+            }
+
+            static float sinpoly(float x)
+            {
+                float x2 = x * x;
+                return x * (1 + x2 * (-1.6666667e-1f + x2 * (8.3333310e-3f +
+                            x2 * (-1.9840874e-4f + x2 * 2.7525562e-6f))));
+            }
+
+            static float cospoly(float x)
+            {
+                float x2 = x * x;
+                return 1 + x2 * (-0.5f + x2 * (4.1666667e-2f + x2 *
+                           (-1.3888889e-3f + x2 * (2.4801587e-5f + x2 *
+                           -2.7557319e-7f))));
+            }
+
+        public:
+
+            static float atan2(float y, float x)
+            {
+                return FastMathPoly::atan2<FastMathTier<1> >(y, x);
+            }
+
+            static float asin(float x)
+            {
+                return FastMathPoly::asin<FastMathTier<1> >(x);
+            }
+
+            static void sincos(float x, float & s, float & c)
+            {
+                float sgn = FastMathPoly::reduce(x);
+                s = sinpoly(x);
+                c = sgn * cospoly(x);
+            }
+
+            static float invSqrt(float x)
+            {
+                return FastMathPoly::invSqrt(x, 2);
+            }
+
+    }; // class FastMathTier<1>
+
+    // Tier 2: rational-linear atan, 7th/8th-order sin/cos, one Newton step ---
+
+    template <> class FastMathTier<2> {
+
+        friend class FastMathPoly;
+
+        private:
+
+            static float atan01(float t)
+            {
+                return 0.78539816f*t - t*(t - 1)*(0.2447f + 0.0663f*t);
+            }
+
+            static float sinpoly(float x)
+            {
+                float x2 = x * x;
+                return x * (1 + x2 * (-1.6666667e-1f + x2 * (8.3333333e-3f +
+                            x2 * -1.9841270e-4f)));
+            }
+
+            static float cospoly(float x)
+            {
+                float x2 = x * x;
+                return 1 + x2 * (-0.5f + x2 * (4.1666667e-2f + x2 *
+                           (-1.3888889e-3f + x2 * 2.4801587e-5f)));
+            }
+
+        public:
+
+            static float atan2(float y, float x)
+            {
+                return FastMathPoly::atan2<FastMathTier<2> >(y, x);
+            }
+
+            static float asin(float x)
+            {
+                return FastMathPoly::asin<FastMathTier<2> >(x);
+            }
+
+            static void sincos(float x, float & s, float & c)
+            {
+                float sgn = FastMathPoly::reduce(x);
+                s = sinpoly(x);
+                c = sgn * cospoly(x);
+            }
+
+            static float invSqrt(float x)
+            {
+                return FastMathPoly::invSqrt(x, 1);
+            }
+
+    }; // class FastMathTier<2>
+
+    typedef FastMathTier<RFT_FASTMATH> FastMath;
+
+} // namespace rft
@@ -0,0 +1,165 @@
+/*
+   Real FFT that can be run a stage at a time
+
+   A real signal of N samples is packed into N/2 complex values, transformed
+   by a radix-2 decimation-in-time FFT and split into the N/2+1 bins of the
+   real spectrum.  load(), each stage() and finish() are separate calls, so
+   that a caller with a per-tick budget can spread one transform over several
+   ticks.
+
+   Real and imaginary parts are kept in separate arrays, and each stage's
+   twiddle factors are contiguous, so the inner loops run over unit-stride
+   float arrays: compilers vectorize them on the host, and on a Cortex-M4 they
+   are plain single-precision FPU code.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+namespace rft {
+
+    template <uint16_t N> struct FftLog2 {
+
+        static const uint8_t value = 1 + FftLog2<N/2>::value;
+    };
+
+    template <> struct FftLog2<1> {
+
+        static const uint8_t value = 0;
+    };
+
+    template <uint16_t N> class RealFft {
+
+        static_assert(N >= 8 && (N & (N-1)) == 0,
+                "FFT size must be a power of two, at least 8");
+
+        public:
+
+            // Complex points and butterfly stages
+            static const uint16_t M = N / 2;
+            static const uint8_t STAGES = FftLog2<M>::value;
+
+            // Bins in the spectrum, DC to Nyquist
+            static const uint16_t BINS = N/2 + 1;
+
+        private:
+
+            float _re[M] = {};
+            float _im[M] = {};
+
+            uint16_t _reversed[M] = {};
+
+            // Per stage, with half-size h, the factors for j < h start at
+            // h-1
+            float _stageCos[M] = {};
+            float _stageSin[M] = {};
+
+            // For splitting the packed transform into the real spectrum
+            float _splitCos[M] = {};
+            float _splitSin[M] = {};
+
+        public:
+
+            RealFft(void)
+            {
+                for (uint16_t k=0; k<M; ++k) {
+
+                    uint16_t r = 0;
+                    for (uint8_t b=0; b<STAGES; ++b) {
+                        r |= ((k >> b) & 1) << (STAGES-1-b);
+                    }
+                    _reversed[k] = r;
+
+                    _splitCos[k] = cosf(2 * (float)M_PI * k / N);
+                    _splitSin[k] = sinf(2 * (float)M_PI * k / N);
+                }
+
+                for (uint16_t half=1; half<M; half*=2) {
+                    for (uint16_t j=0; j<half; ++j) {
+                        _stageCos[half-1+j] = cosf((float)M_PI * j / half);
+                        _stageSin[half-1+j] = sinf((float)M_PI * j / half);
+                    }
+                }
+            }
+
+            // N real samples, in bit-reversed order for the stages
+            void load(const float * x)
+            {
+                for (uint16_t k=0; k<M; ++k) {
+                    uint16_t r = _reversed[k];
+                    _re[r] = x[2*k];
+                    _im[r] = x[2*k+1];
+                }
+            }
+
+            // Butterflies of stage s, for s in [0, STAGES)
+            void stage(uint8_t s)
+            {
+                uint16_t half = 1 << s;
+
+                const float * wr = &_stageCos[half-1];
+                const float * wi = &_stageSin[half-1];
+
+                for (uint16_t start=0; start<M; start+=2*half) {
+
+                    float * ar = &_re[start];
+                    float * ai = &_im[start];
+                    float * br = &_re[start+half];
+                    float * bi = &_im[start+half];
+
+                    // Multiplying by exp(-i pi j / half)
+                    for (uint16_t j=0; j<half; ++j) {
+                        float tr = br[j] * wr[j] + bi[j] * wi[j];
+                        float ti = bi[j] * wr[j] - br[j] * wi[j];
+                        br[j] = ar[j] - tr;
+                        bi[j] = ai[j] - ti;
+                        ar[j] += tr;
+                        ai[j] += ti;
+                    }
+                }
+            }
+
+            // Squared magnitude of each of the BINS bins
+            void finish(float * power)
+            {
+                for (uint16_t k=0; k<=M; ++k) {
+
+                    uint16_t j = k % M;
+                    uint16_t l = (M - k) % M;
+
+                    // Even and odd halves of the spectrum
+                    float er = (_re[j] + _re[l]) / 2;
+                    float ei = (_im[j] - _im[l]) / 2;
+                    float or_ = (_im[j] + _im[l]) / 2;
+                    float oi = (_re[l] - _re[j]) / 2;
+
+                    // exp(-2 pi i k / N), with cos(pi)=-1 at k = M
+                    float c = k < M ? _splitCos[k] : -1;
+                    float s = k < M ? _splitSin[k] : 0;
+
+                    float xr = er + or_ * c + oi * s;
+                    float xi = ei + oi * c - or_ * s;
+
+                    power[k] = xr * xr + xi * xi;
+                }
+            }
+
+            // The whole transform at once
+            void transform(const float * x, float * power)
+            {
+                load(x);
+                for (uint8_t s=0; s<STAGES; ++s) {
+                    stage(s);
+                }
+                finish(power);
+            }
+
+    }; // class RealFft
+
+} // namespace rft
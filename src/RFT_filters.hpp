@@ -11,6 +11,10 @@
 #include <math.h>
 #include <stdint.h>
 
+#include "RFT_fastmath.hpp"
+#include "RFT_footprint.hpp"
+#include "RFT_linalg.hpp"
+
 #ifndef M_PI
 static const float M_PI = 3.141593;
 #endif
@@ -21,15 +25,24 @@ namespace rft {
 
         private:
 
-            // y = Ax + b helper for frame-of-reference conversion methods
-            static void dot(float A[3][3], float x[3], float y[3])
+            // Body-from-inertial rotation helper for frame-of-reference
+            // conversion methods
+            static Mat<3,3> rotationMatrix(const float rotation[3])
             {
-                for (uint8_t j = 0; j < 3; ++j) {
-                    y[j] = 0;
-                    for (uint8_t k = 0; k < 3; ++k) {
-                        y[j] += A[j][k] * x[k];
-                    }
-                }
+                float phi = rotation[0];
+                float theta = rotation[1];
+                float psi = rotation[2];
+
+                float cph, sph, cth, sth, cps, sps;
+                FastMath::sincos(phi, sph, cph);
+                FastMath::sincos(theta, sth, cth);
+                FastMath::sincos(psi, sps, cps);
+
+                Mat<3,3> R = { { {cps * cth,                cth * sps,                   -sth},
+                    {cps * sph * sth - cph * sps,  cph * cps + sph * sps * sth,  cth * sph},
+                    {sph * sps + cph * cps * sth,  cph * sps * sth - cps * sph,  cph * cth} } };
+
+                return R;
             }
 
         public:
@@ -52,9 +65,9 @@ namespace rft {
             static void quat2euler(float qw, float qx, float qy, float qz,
                     float & ex, float & ey, float & ez)
             {
-                ex = atan2(2.0f*(qw*qx+qy*qz), qw*qw-qx*qx-qy*qy+qz*qz);
-                ey = asin(2.0f*(qx*qz-qw*qy));
-                ez = atan2(2.0f*(qx*qy+qw*qz), qw*qw+qx*qx-qy*qy-qz*qz);
+                ex = FastMath::atan2(2.0f*(qw*qx+qy*qz), qw*qw-qx*qx-qy*qy+qz*qz);
+                ey = FastMath::asin(2.0f*(qx*qz-qw*qy));
+                ez = FastMath::atan2(2.0f*(qx*qy+qw*qz), qw*qw+qx*qx-qy*qy-qz*qz);
             }
 
             static void euler2quat(const float eulerAngles[3], float quaternion[4])
@@ -65,12 +78,10 @@ namespace rft {
                 float psi = eulerAngles[2] / 2;
 
                 // Pre-computation
-                float cph = cos(phi);
-                float cth = cos(the);
-                float cps = cos(psi);
-                float sph = sin(phi);
-                float sth = sin(the);
-                float sps = sin(psi);
+                float cph, cth, cps, sph, sth, sps;
+                FastMath::sincos(phi, sph, cph);
+                FastMath::sincos(the, sth, cth);
+                FastMath::sincos(psi, sps, cps);
 
                 // Conversion
                 quaternion[0] = cph * cth * cps + sph * sth * sps;
@@ -91,42 +102,24 @@ namespace rft {
 
             static void inertial2body(float inertial[3], const float rotation[3], float body[3])
             {
-                float phi = rotation[0];
-                float theta = rotation[1];
-                float psi = rotation[2];
-
-                float cph = cos(phi);
-                float sph = sin(phi);
-                float cth = cos(theta);
-                float sth = sin(theta);
-                float cps = cos(psi);
-                float sps = sin(psi);
+                Vec<3> x = { {inertial[0], inertial[1], inertial[2]} };
 
-                float R[3][3] = { {cps * cth,                cth * sps,                   -sth},
-                    {cps * sph * sth - cph * sps,  cph * cps + sph * sps * sth,  cth * sph},
-                    {sph * sps + cph * cps * sth,  cph * sps * sth - cps * sph,  cph * cth} };
+                Vec<3> y = rotationMatrix(rotation) * x;
 
-                dot(R, inertial, body);
+                body[0] = y[0];
+                body[1] = y[1];
+                body[2] = y[2];
             }
 
             static void body2inertial(float body[3], const float rotation[3], float inertial[3])
             {
-                float phi = rotation[0];
-                float theta = rotation[1];
-                float psi = rotation[2];
+                Vec<3> x = { {body[0], body[1], body[2]} };
 
-                float cph = cos(phi);
-                float sph = sin(phi);
-                float cth = cos(theta);
-                float sth = sin(theta);
-                float cps = cos(psi);
-                float sps = sin(psi);
+                Vec<3> y = rotationMatrix(rotation).transposeTimes(x);
 
-                float R[3][3] = { {cps * cth,  cps * sph * sth - cph * sps,  sph * sps + cph * cps * sth},
-                    {cth * sps,  cph * cps + sph * sps * sth,  cph * sps * sth - cps * sph},
-                    {-sth,     cth * sph,                cph * cth} };
-
-                dot(R, body, inertial);
+                inertial[0] = y[0];
+                inertial[1] = y[1];
+                inertial[2] = y[2];
             }
 
     }; // class Filter
@@ -156,6 +149,14 @@ namespace rft {
                 _sum = 0;
             }
 
+            // Most of the history usually goes unused; e.g., from a
+            // sensor's begin() with RFTPure::footprint()
+            void addFootprint(Footprint & footprint)
+            {
+                footprint.add("LowPassFilter", sizeof(*this), 256,
+                        &_historySize, sizeof(float));
+            }
+
             float update(float value)
             {
                 uint8_t indexplus1 = (_historyIdx + 1) % _historySize;
@@ -168,6 +169,245 @@ namespace rft {
 
     }; // class LowPassFilter
 
+    // Normalized coefficients of a second-order IIR section, from the RBJ
+    // audio-EQ cookbook.  The designs are constexpr, so when the rate and
+    // cutoff are known at compile time the compiler computes them:
+    //
+    //     // Fourth-order Butterworth low-pass at 80 Hz for a 1 kHz gyro
+    //     static constexpr BiquadCoefficients GYRO_LPF[2] = {
+    //         BiquadCoefficients::butterworth(80, 1000, 2, 0),
+    //         BiquadCoefficients::butterworth(80, 1000, 2, 1)
+    //     };
+    //
+    // Frequencies must lie below the Nyquist frequency, rate/2.
+    class BiquadCoefficients {
+
+        friend class BiquadFilter;
+
+        template <uint8_t AXES, uint8_t SECTIONS>
+        friend class BiquadCascade;
+
+        private:
+
+            static constexpr double PI_D = 3.14159265358979;
+
+            float _b0;
+            float _b1;
+            float _b2;
+            float _a1;
+            float _a2;
+
+            // Taylor series of sine (term=x, n=2) or cosine (term=1, n=1),
+            // accurate to double precision for |x| <= pi
+            static constexpr double series(double x2, double term, uint8_t n,
+                    double sum)
+            {
+                return n > 24 ? sum :
+                    series(x2, -term * x2 / (n * (n+1)), n+2, sum + term);
+            }
+
+            static constexpr double sine(double x)
+            {
+                return series(x * x, x, 2, 0);
+            }
+
+            static constexpr double cosine(double x)
+            {
+                return series(x * x, 1, 1, 0);
+            }
+
+            static constexpr double angle(float freq, float rate)
+            {
+                return 2 * PI_D * freq / rate;
+            }
+
+            constexpr BiquadCoefficients(float b0, float b1, float b2,
+                    float a0, float a1, float a2)
+                : _b0(b0 / a0), _b1(b1 / a0), _b2(b2 / a0),
+                  _a1(a1 / a0), _a2(a2 / a0)
+            {
+            }
+
+            // From the sine and cosine of the center or cutoff angle, so
+            // that retuning at run time can use FastMath::sincos
+
+            static constexpr BiquadCoefficients lowPassFrom(float sn,
+                    float cs, float q)
+            {
+                return BiquadCoefficients((1 - cs) / 2, 1 - cs, (1 - cs) / 2,
+                        1 + sn / (2 * q), -2 * cs, 1 - sn / (2 * q));
+            }
+
+            static constexpr BiquadCoefficients notchFrom(float sn, float cs,
+                    float q)
+            {
+                return BiquadCoefficients(1, -2 * cs, 1,
+                        1 + sn / (2 * q), -2 * cs, 1 - sn / (2 * q));
+            }
+
+        public:
+
+            // Passes its input through unchanged
+            constexpr BiquadCoefficients(void)
+                : _b0(1), _b1(0), _b2(0), _a1(0), _a2(0)
+            {
+            }
+
+            static constexpr BiquadCoefficients lowPass(float freq,
+                    float rate, float q=0.7071f)
+            {
+                return lowPassFrom(sine(angle(freq, rate)),
+                        cosine(angle(freq, rate)), q);
+            }
+
+            // Removes freq Hz, with bandwidth freq/q
+            static constexpr BiquadCoefficients notch(float freq, float rate,
+                    float q)
+            {
+                return notchFrom(sine(angle(freq, rate)),
+                        cosine(angle(freq, rate)), q);
+            }
+
+            // Section k, of sections, of a Butterworth low-pass of order
+            // 2 * sections
+            static constexpr BiquadCoefficients butterworth(float freq,
+                    float rate, uint8_t sections, uint8_t k)
+            {
+                return lowPass(freq, rate,
+                        1 / (2 * sine(PI_D * (2*k + 1) / (4 * sections))));
+            }
+
+    }; // class BiquadCoefficients
+
+    // Second-order IIR section in transposed direct form II
+    class BiquadFilter {
+
+        private:
+
+            BiquadCoefficients _c;
+
+            float _z1 = 0;
+            float _z2 = 0;
+
+        public:
+
+            void set(const BiquadCoefficients & c)
+            {
+                _c = c;
+            }
+
+            // Removes freq Hz, with bandwidth freq/q, at rate samples per
+            // second; the state is kept, so this can retune a running filter
+            void setNotch(float freq, float rate, float q)
+            {
+                float sn = 0, cs = 0;
+                FastMath::sincos(2 * (float)M_PI * freq / rate, sn, cs);
+                _c = BiquadCoefficients::notchFrom(sn, cs, q);
+            }
+
+            void setLowPass(float freq, float rate, float q=0.7071f)
+            {
+                float sn = 0, cs = 0;
+                FastMath::sincos(2 * (float)M_PI * freq / rate, sn, cs);
+                _c = BiquadCoefficients::lowPassFrom(sn, cs, q);
+            }
+
+            void begin(void)
+            {
+                _z1 = 0;
+                _z2 = 0;
+            }
+
+            float update(float x)
+            {
+                float y = _c._b0 * x + _z1;
+                _z1 = _c._b1 * x - _c._a1 * y + _z2;
+                _z2 = _c._b2 * x - _c._a2 * y;
+                return y;
+            }
+
+    }; // class BiquadFilter
+
+    // The same cascade of biquad sections run on several axes in one call.
+    // The axes' states sit side by side in rows, so each step of a section is
+    // one identical operation across a row, which compilers turn into vector
+    // instructions on the host (four axes fill an SSE or NEON register
+    // exactly).  The coefficients are stored once for all axes, in an array
+    // the caller provides and that can be constexpr:
+    //
+    //     static BiquadCascade<3, 2> gyroFilter(GYRO_LPF);
+    //
+    //     float gyro[3] = ...;
+    //     gyroFilter.update(gyro, gyro);
+    template <uint8_t AXES=3, uint8_t SECTIONS=1>
+    class BiquadCascade {
+
+        static_assert(AXES >= 1 && SECTIONS >= 1,
+                "need at least one axis and one section");
+
+        private:
+
+            const BiquadCoefficients * _sections = nullptr;
+
+            float _z1[SECTIONS][AXES] = {};
+            float _z2[SECTIONS][AXES] = {};
+
+        public:
+
+            // sections: SECTIONS coefficient sets, applied in order
+            constexpr BiquadCascade(const BiquadCoefficients * sections)
+                : _sections(sections)
+            {
+            }
+
+            // Changes the design, keeping the state
+            void set(const BiquadCoefficients * sections)
+            {
+                _sections = sections;
+            }
+
+            void begin(void)
+            {
+                for (uint8_t s=0; s<SECTIONS; ++s) {
+                    for (uint8_t a=0; a<AXES; ++a) {
+                        _z1[s][a] = 0;
+                        _z2[s][a] = 0;
+                    }
+                }
+            }
+
+            // in and out may be the same array
+            void update(const float * in, float * out)
+            {
+                float x[AXES];
+                for (uint8_t a=0; a<AXES; ++a) {
+                    x[a] = in[a];
+                }
+
+                for (uint8_t s=0; s<SECTIONS; ++s) {
+
+                    // Shared by all axes, and known not to alias the state
+                    const float b0 = _sections[s]._b0;
+                    const float b1 = _sections[s]._b1;
+                    const float b2 = _sections[s]._b2;
+                    const float a1 = _sections[s]._a1;
+                    const float a2 = _sections[s]._a2;
+
+                    for (uint8_t a=0; a<AXES; ++a) {
+                        float y = b0 * x[a] + _z1[s][a];
+                        _z1[s][a] = b1 * x[a] - a1 * y + _z2[s][a];
+                        _z2[s][a] = b2 * x[a] - a2 * y;
+                        x[a] = y;
+                    }
+                }
+
+                for (uint8_t a=0; a<AXES; ++a) {
+                    out[a] = x[a];
+                }
+            }
+
+    }; // class BiquadCascade
+
     class QuaternionFilter {
 
         public:
@@ -241,17 +481,17 @@ namespace rft {
                 float q4q4 = q4 * q4;
 
                 // Normalise accelerometer measurement
-                norm = sqrtf(ax * ax + ay * ay + az * az);
+                norm = ax * ax + ay * ay + az * az;
                 if (norm == 0.0f) return; // handle NaN
-                norm = 1.0f/norm;
+                norm = FastMath::invSqrt(norm);
                 ax *= norm;
                 ay *= norm;
                 az *= norm;
 
                 // Normalise magnetometer measurement
-                norm = sqrtf(mx * mx + my * my + mz * mz);
+                norm = mx * mx + my * my + mz * mz;
                 if (norm == 0.0f) return; // handle NaN
-                norm = 1.0f/norm;
+                norm = FastMath::invSqrt(norm);
                 mx *= norm;
                 my *= norm;
                 mz *= norm;
@@ -293,8 +533,7 @@ namespace rft {
                     _2bx * q2 * (_2bx * (q1q3 + q2q4) + _2bz * (0.5f - q2q2 - q3q3) - mz);
 
                 // Normalize step magnitude
-                norm = sqrtf(s1 * s1 + s2 * s2 + s3 * s3 + s4 * s4);    
-                norm = 1.0f/norm;
+                norm = FastMath::invSqrt(s1 * s1 + s2 * s2 + s3 * s3 + s4 * s4);    
                 s1 *= norm;
                 s2 *= norm;
                 s3 *= norm;
@@ -311,8 +550,11 @@ namespace rft {
                 q2 += qDot2 * deltat;
                 q3 += qDot3 * deltat;
                 q4 += qDot4 * deltat;
-                norm = sqrtf(q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4);    // normalise quaternion
-                norm = 1.0f/norm;
+                norm = FastMath::invSqrt(q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4);    // normalise quaternion
+                q1 *= norm;
+                q2 *= norm;
+                q3 *= norm;
+                q4 *= norm;
             }
     }; // class MadgwickQuaternionFilter9DOF 
 
@@ -322,6 +564,11 @@ namespace rft {
 
             float _zeta = 0;
 
+            // Gyro bias error
+            float _gbiasx = 0;
+            float _gbiasy = 0;
+            float _gbiasz = 0;
+
         public:
 
             MadgwickQuaternionFilter6DOF(float beta, float zeta) 
@@ -333,8 +580,6 @@ namespace rft {
             // Adapted from https://github.com/kriswiner/MPU6050/blob/master/quaternionFilter.ino
             void update(float ax, float ay, float az, float gx, float gy, float gz, float deltat)
             {
-                static float gbiasx, gbiasy, gbiasz;        // gyro bias error
-
                 // Auxiliary variables to avoid repeated arithmetic
                 float _halfq1 = 0.5f * q1;
                 float _halfq2 = 0.5f * q2;
@@ -348,9 +593,9 @@ namespace rft {
                 //float _2q3q4 = 2.0f * q3 * q4;
 
                 // Normalise accelerometer measurement
-                float norm = sqrt(ax * ax + ay * ay + az * az);
+                float norm = ax * ax + ay * ay + az * az;
                 if (norm == 0.0f) return; // handle NaN
-                norm = 1.0f/norm;
+                norm = FastMath::invSqrt(norm);
                 ax *= norm;
                 ay *= norm;
                 az *= norm;
@@ -373,11 +618,11 @@ namespace rft {
                 float hatDot4 = J_14or21 * f1 + J_11or24 * f2;
 
                 // Normalize the gradient
-                norm = sqrt(hatDot1 * hatDot1 + hatDot2 * hatDot2 + hatDot3 * hatDot3 + hatDot4 * hatDot4);
-                hatDot1 /= norm;
-                hatDot2 /= norm;
-                hatDot3 /= norm;
-                hatDot4 /= norm;
+                norm = FastMath::invSqrt(hatDot1 * hatDot1 + hatDot2 * hatDot2 + hatDot3 * hatDot3 + hatDot4 * hatDot4);
+                hatDot1 *= norm;
+                hatDot2 *= norm;
+                hatDot3 *= norm;
+                hatDot4 *= norm;
 
                 // Compute estimated gyroscope biases
                 float gerrx = _2q1 * hatDot2 - _2q2 * hatDot1 - _2q3 * hatDot4 + _2q4 * hatDot3;
@@ -385,12 +630,12 @@ namespace rft {
                 float gerrz = _2q1 * hatDot4 - _2q2 * hatDot3 + _2q3 * hatDot2 - _2q4 * hatDot1;
 
                 // Compute and remove gyroscope biases
-                gbiasx += gerrx * deltat * _zeta;
-                gbiasy += gerry * deltat * _zeta;
-                gbiasz += gerrz * deltat * _zeta;
-                gx -= gbiasx;
-                gy -= gbiasy;
-                gz -= gbiasz;
+                _gbiasx += gerrx * deltat * _zeta;
+                _gbiasy += gerry * deltat * _zeta;
+                _gbiasz += gerrz * deltat * _zeta;
+                gx -= _gbiasx;
+                gy -= _gbiasy;
+                gz -= _gbiasz;
 
                 // Compute the quaternion derivative
                 float qDot1 = -_halfq2 * gx - _halfq3 * gy - _halfq4 * gz;
@@ -405,8 +650,7 @@ namespace rft {
                 q4 += (qDot4 -(_beta * hatDot4)) * deltat;
 
                 // Normalize the quaternion
-                norm = sqrt(q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4);    // normalise quaternion
-                norm = 1.0f/norm;
+                norm = FastMath::invSqrt(q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4);    // normalise quaternion
                 q1 *= norm;
                 q2 *= norm;
                 q3 *= norm;
@@ -457,17 +701,17 @@ namespace rft {
                 float q4q4 = q4 * q4;   
 
                 // Normalise accelerometer measurement
-                norm = sqrtf(ax * ax + ay * ay + az * az);
+                norm = ax * ax + ay * ay + az * az;
                 if (norm == 0.0f) return; // handle NaN
-                norm = 1.0f / norm;        // use reciprocal for division
+                norm = FastMath::invSqrt(norm);
                 ax *= norm;
                 ay *= norm;
                 az *= norm;
 
                 // Normalise magnetometer measurement
-                norm = sqrtf(mx * mx + my * my + mz * mz);
+                norm = mx * mx + my * my + mz * mz;
                 if (norm == 0.0f) return; // handle NaN
-                norm = 1.0f / norm;        // use reciprocal for division
+                norm = FastMath::invSqrt(norm);
                 mx *= norm;
                 my *= norm;
                 mz *= norm;
@@ -518,8 +762,7 @@ namespace rft {
                 q4 = pc + (q1 * gz + pa * gy - pb * gx) * (0.5f * deltat);
 
                 // Normalise quaternion
-                norm = sqrtf(q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4);
-                norm = 1.0f / norm;
+                norm = FastMath::invSqrt(q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4);
                 q1 *= norm;
                 q2 *= norm;
                 q3 *= norm;
@@ -0,0 +1,208 @@
+/*
+   Run-time accounting of RAM use
+
+   Each RFTPure keeps a Footprint, in which the framework objects it runs
+   register their size and, for those with a fixed buffer or array inside,
+   its capacity and a high-water mark of how much of it has been used.
+   SerialTask reports the entries over MSP (FOOTPRINT_GET, one entry per
+   request, answered with a Footprint::MSP_ID message holding the name as
+   text), and extras/footprint/footprint.py prints them as a table, so
+   buffers can be sized from what a flight actually needed:
+
+       void addFootprint(Footprint & footprint)
+       {
+           footprint.add("LowPassFilter", sizeof(*this),
+                         256, &_historySize, sizeof(float));
+       }
+
+   The last entry is the stack.  On the ESP32 its use is FreeRTOS's exact
+   high-water mark for the loop task.  Elsewhere it is sampled, by
+   sampleStack() calls from the tasks RFTPure schedules and from wherever
+   else you put one, as the depth below the frame of RFTPure::update(); that
+   is a lower bound, since deeper calls between samples are missed.  Since
+   each pass marks its own top, samples compare stack addresses of the same
+   thread even where vehicles move between threads, as in the SITL runner.
+   Define RFT_STACK_SIZE to report the capacity too.
+
+   Define RFT_FOOTPRINT_MAX (default 24) to change the number of entries.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+#ifndef RFT_FOOTPRINT_MAX
+#define RFT_FOOTPRINT_MAX 24
+#endif
+
+#ifndef RFT_STACK_SIZE
+#if defined(ESP32) && defined(CONFIG_ARDUINO_LOOP_STACK_SIZE)
+#define RFT_STACK_SIZE CONFIG_ARDUINO_LOOP_STACK_SIZE
+#else
+#define RFT_STACK_SIZE 0
+#endif
+#endif
+
+namespace rft {
+
+    class Footprint {
+
+        public:
+
+            // Just below the debug-message ID used by Logger
+            static const uint8_t MSP_ID = 252;
+
+            // Longest name sent
+            static const uint8_t NAME_SIZE = 24;
+
+        private:
+
+            typedef struct {
+
+                const char * name;
+                uint32_t size;
+                uint32_t capacity;
+
+                // High-water mark, in elements of unit bytes
+                const void * used;
+                uint8_t width;
+                uint16_t unit;
+
+            } entry_t;
+
+            entry_t _entries[RFT_FOOTPRINT_MAX] = {};
+            uint8_t _count = 0;
+            uint8_t _dropped = 0;
+
+            // Top of the stack for this pass, and the deepest seen below
+            // the top of any pass
+            uintptr_t _stackTop = 0;
+            uint32_t _stackDepth = 0;
+
+            void addEntry(const char * name, uint32_t size, uint32_t capacity,
+                    const void * used, uint8_t width, uint16_t unit)
+            {
+                // Objects that begin() more than once are counted once
+                for (uint8_t k=0; k<_count; ++k) {
+                    if (_entries[k].name == name && _entries[k].used == used) {
+                        return;
+                    }
+                }
+
+                if (_count == RFT_FOOTPRINT_MAX) {
+                    _dropped++;
+                    return;
+                }
+
+                entry_t & e = _entries[_count++];
+
+                e.name = name;
+                e.size = size;
+                e.capacity = capacity;
+                e.used = used;
+                e.width = width;
+                e.unit = unit;
+            }
+
+            static uint32_t read(const entry_t & e)
+            {
+                return e.width == 1 ? *(const volatile uint8_t *)e.used
+                    : e.width == 2 ? *(const volatile uint16_t *)e.used
+                    : e.width == 4 ? *(const volatile uint32_t *)e.used
+                    : 0;
+            }
+
+        public:
+
+            // An object with no buffer worth tracking
+            void add(const char * name, uint32_t size)
+            {
+                addEntry(name, size, 0, NULL, 0, 0);
+            }
+
+            // An object with a buffer of capacity elements of unit bytes,
+            // and a count of the most it has held; name should be a string
+            // literal, which is kept rather than copied
+            template <typename T>
+            void add(const char * name, uint32_t size, uint32_t capacity,
+                    const T * used, uint16_t unit=1)
+            {
+                static_assert(sizeof(T) == 1 || sizeof(T) == 2 ||
+                        sizeof(T) == 4, "high-water mark must be an integer");
+
+                addEntry(name, size, capacity, used, sizeof(T), unit);
+            }
+
+            // Called by RFTPure::update() before anything else
+            void markStack(void)
+            {
+                volatile uint8_t marker = 0;
+                _stackTop = (uintptr_t)&marker;
+            }
+
+            // Cheap enough for any code path under RFTPure::update()
+            void sampleStack(void)
+            {
+                volatile uint8_t marker = 0;
+                uintptr_t sp = (uintptr_t)&marker;
+
+                if (_stackTop > sp && _stackTop - sp > _stackDepth) {
+                    _stackDepth = _stackTop - sp;
+                }
+            }
+
+            // Entries, plus one for the stack
+            uint8_t count(void)
+            {
+                return _count + 1;
+            }
+
+            // Entries that didn't fit
+            uint8_t dropped(void)
+            {
+                return _dropped;
+            }
+
+            // Sizes in bytes; returns false for a bad index
+            bool describe(uint8_t index, const char * & name, uint32_t & size,
+                    uint32_t & capacity, uint32_t & used)
+            {
+                if (index < _count) {
+                    const entry_t & e = _entries[index];
+                    name = e.name;
+                    size = e.size;
+                    capacity = e.capacity * e.unit;
+                    used = e.used ? read(e) * e.unit : 0;
+                    return true;
+                }
+
+                if (index == _count) {
+                    name = "stack";
+                    size = 0;
+                    capacity = RFT_STACK_SIZE;
+#ifdef ESP32
+                    // In bytes on the ESP32, for the task calling this
+                    uint32_t spare = uxTaskGetStackHighWaterMark(NULL);
+                    used = capacity > spare ? capacity - spare : 0;
+#else
+                    used = _stackDepth;
+#endif
+                    return true;
+                }
+
+                return false;
+            }
+
+    }; // class Footprint
+
+} // namespace rft
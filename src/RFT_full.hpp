@@ -21,6 +21,17 @@ namespace rft {
             SerialTask * _serial_tasks[10] = {};
             uint8_t _serial_task_count = 0;
 
+            static bool serialTask(void * context, uint8_t index)
+            {
+                RFT * rft = (RFT *)context;
+
+                rft->footprint().sampleStack();
+
+                return rft->_serial_tasks[index]->run(rft->_board,
+                                                      rft->_actuator,
+                                                      rft->_state);
+            }
+
         protected:
 
             RFT(Board * board, OpenLoopController * olc, Actuator * actuator)
@@ -31,16 +42,24 @@ namespace rft {
 
             void update(State * state)
             {
+                // Serial tasks are among the scheduled ones
                 RFTPure::update(state);
-
-                // Update serial tasks
-                for (uint8_t k=0; k<_serial_task_count; ++k) {
-                    _serial_tasks[k]->update(_board, _actuator, state);
-                }
             }
 
+            // A serial task stopping at its budget yields, and is resumed
+            // once anything more urgent has run
             void addSerialTask(SerialTask * task)
             {
+                if (_serial_task_count == 0) {
+                    footprint().add("RFT", sizeof(RFT) - sizeof(RFTPure), 10,
+                            &_serial_task_count, sizeof(SerialTask *));
+                }
+
+                task->addFootprint(footprint());
+
+                _scheduler.add(serialTask, this, _serial_task_count,
+                               task->period(), Scheduler::COMMS);
+
                 _serial_tasks[_serial_task_count++] = task;
             }
 
@@ -0,0 +1,322 @@
+/*
+   Fixed-size, heap-free vector and matrix templates for estimators
+
+   Dimensions are template parameters, so all storage is static and loops
+   over them are unrolled at compile time.  SymMat stores only the lower
+   triangle and supports an in-place LDL' factorization and solve.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace rft {
+
+    // Calls f(0) ... f(N-1) with no loop overhead
+    template <uint8_t N> class Unroll {
+
+        public:
+
+            template <typename F>
+            static void run(F & f)
+            {
+                Unroll<N-1>::run(f);
+                f(N-1);
+            }
+
+    }; // class Unroll
+
+    template <> class Unroll<0> {
+
+        public:
+
+            template <typename F>
+            static void run(F & f)
+            {
+                (void)f;
+            }
+
+    }; // class Unroll<0>
+
+    // Accumulates a[k*sa] * b[k*sb], for use with Unroll
+    class DotKernel {
+
+        public:
+
+            const float * a;
+            uint8_t sa;
+            const float * b;
+            uint8_t sb;
+            float sum;
+
+            void operator()(uint8_t k)
+            {
+                sum += a[k*sa] * b[k*sb];
+            }
+
+    }; // class DotKernel
+
+    template <uint8_t N> class Vec {
+
+        public:
+
+            float v[N];
+
+            static Vec zeros(void)
+            {
+                Vec z;
+                for (uint8_t k=0; k<N; ++k) {
+                    z.v[k] = 0;
+                }
+                return z;
+            }
+
+            float & operator[](uint8_t k)
+            {
+                return v[k];
+            }
+
+            const float & operator[](uint8_t k) const
+            {
+                return v[k];
+            }
+
+            float dot(const Vec & other) const
+            {
+                DotKernel d = {v, 1, other.v, 1, 0};
+                Unroll<N>::run(d);
+                return d.sum;
+            }
+
+            Vec operator+(const Vec & other) const
+            {
+                Vec r;
+                for (uint8_t k=0; k<N; ++k) {
+                    r.v[k] = v[k] + other.v[k];
+                }
+                return r;
+            }
+
+            Vec operator-(const Vec & other) const
+            {
+                Vec r;
+                for (uint8_t k=0; k<N; ++k) {
+                    r.v[k] = v[k] - other.v[k];
+                }
+                return r;
+            }
+
+            Vec operator*(float s) const
+            {
+                Vec r;
+                for (uint8_t k=0; k<N; ++k) {
+                    r.v[k] = v[k] * s;
+                }
+                return r;
+            }
+
+    }; // class Vec
+
+    template <uint8_t R, uint8_t C> class Mat {
+
+        public:
+
+            float m[R][C];
+
+            static Mat zeros(void)
+            {
+                Mat z;
+                for (uint8_t j=0; j<R; ++j) {
+                    for (uint8_t k=0; k<C; ++k) {
+                        z.m[j][k] = 0;
+                    }
+                }
+                return z;
+            }
+
+            static Mat identity(void)
+            {
+                Mat z = zeros();
+                for (uint8_t k=0; k<R && k<C; ++k) {
+                    z.m[k][k] = 1;
+                }
+                return z;
+            }
+
+            float & operator()(uint8_t j, uint8_t k)
+            {
+                return m[j][k];
+            }
+
+            const float & operator()(uint8_t j, uint8_t k) const
+            {
+                return m[j][k];
+            }
+
+            // y = Ax
+            Vec<R> operator*(const Vec<C> & x) const
+            {
+                Vec<R> y;
+                for (uint8_t j=0; j<R; ++j) {
+                    DotKernel row = {m[j], 1, x.v, 1, 0};
+                    Unroll<C>::run(row);
+                    y.v[j] = row.sum;
+                }
+                return y;
+            }
+
+            // y = A'x, without forming the transpose
+            Vec<C> transposeTimes(const Vec<R> & x) const
+            {
+                Vec<C> y;
+                for (uint8_t k=0; k<C; ++k) {
+                    DotKernel col = {&m[0][k], C, x.v, 1, 0};
+                    Unroll<R>::run(col);
+                    y.v[k] = col.sum;
+                }
+                return y;
+            }
+
+            template <uint8_t K>
+            Mat<R,K> operator*(const Mat<C,K> & b) const
+            {
+                Mat<R,K> p;
+                for (uint8_t j=0; j<R; ++j) {
+                    for (uint8_t k=0; k<K; ++k) {
+                        DotKernel row = {m[j], 1, &b.m[0][k], K, 0};
+                        Unroll<C>::run(row);
+                        p.m[j][k] = row.sum;
+                    }
+                }
+                return p;
+            }
+
+            Mat<C,R> transpose(void) const
+            {
+                Mat<C,R> t;
+                for (uint8_t j=0; j<R; ++j) {
+                    for (uint8_t k=0; k<C; ++k) {
+                        t.m[k][j] = m[j][k];
+                    }
+                }
+                return t;
+            }
+
+    }; // class Mat
+
+    template <uint8_t N> class SymMat {
+
+        private:
+
+            static uint16_t index(uint8_t j, uint8_t k)
+            {
+                return j >= k ? j*(j+1)/2 + k : k*(k+1)/2 + j;
+            }
+
+        public:
+
+            static const uint16_t SIZE = N*(N+1)/2;
+
+            // Packed lower triangle, row by row
+            float s[SIZE];
+
+            static SymMat zeros(void)
+            {
+                SymMat z;
+                for (uint16_t k=0; k<SIZE; ++k) {
+                    z.s[k] = 0;
+                }
+                return z;
+            }
+
+            float & operator()(uint8_t j, uint8_t k)
+            {
+                return s[index(j, k)];
+            }
+
+            const float & operator()(uint8_t j, uint8_t k) const
+            {
+                return s[index(j, k)];
+            }
+
+            Vec<N> operator*(const Vec<N> & x) const
+            {
+                Vec<N> y = Vec<N>::zeros();
+                for (uint8_t j=0; j<N; ++j) {
+                    for (uint8_t k=0; k<N; ++k) {
+                        y.v[j] += s[index(j, k)] * x.v[k];
+                    }
+                }
+                return y;
+            }
+
+            // Overwrites this matrix with L (unit diagonal, not stored) below
+            // the diagonal and D on the diagonal.  Returns false if the
+            // matrix is not positive definite.
+            bool factorLDL(void)
+            {
+                for (uint8_t j=0; j<N; ++j) {
+
+                    float d = s[index(j, j)];
+                    for (uint8_t k=0; k<j; ++k) {
+                        float ljk = s[index(j, k)];
+                        d -= ljk * ljk * s[index(k, k)];
+                    }
+
+                    if (d <= 0) {
+                        return false;
+                    }
+
+                    s[index(j, j)] = d;
+
+                    for (uint8_t i=j+1; i<N; ++i) {
+                        float a = s[index(i, j)];
+                        for (uint8_t k=0; k<j; ++k) {
+                            a -= s[index(i, k)] * s[index(j, k)] *
+                                 s[index(k, k)];
+                        }
+                        s[index(i, j)] = a / d;
+                    }
+                }
+
+                return true;
+            }
+
+            // Solves LDL'x = b in place after factorLDL()
+            void solveLDL(Vec<N> & b) const
+            {
+                for (uint8_t j=0; j<N; ++j) {
+                    for (uint8_t k=0; k<j; ++k) {
+                        b.v[j] -= s[index(j, k)] * b.v[k];
+                    }
+                }
+
+                for (uint8_t j=0; j<N; ++j) {
+                    b.v[j] /= s[index(j, j)];
+                }
+
+                for (int8_t j=N-1; j>=0; --j) {
+                    for (uint8_t k=j+1; k<N; ++k) {
+                        b.v[j] -= s[index(k, j)] * b.v[k];
+                    }
+                }
+            }
+
+            // Solves Ax = b in place, destroying A; returns false if A is not
+            // positive definite
+            bool solve(Vec<N> & b)
+            {
+                if (!factorLDL()) {
+                    return false;
+                }
+                solveLDL(b);
+                return true;
+            }
+
+    }; // class SymMat
+
+} // namespace rft
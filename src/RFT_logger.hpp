@@ -0,0 +1,338 @@
+/*
+   Deferred binary logging for code on the control-loop path
+
+   RFT_LOG("fmt", args...) records a sixteen-bit ID computed from the format
+   string at compile time, followed by the raw arguments, into a fixed ring
+   buffer.  Nothing is formatted on the vehicle: SerialTask drains whole
+   records into MSP messages of type Logger::MSP_ID, and extras/logger/rftlog.py rebuilds the
+   text on the host from a table of the format strings it finds in the
+   sources.
+
+   Arguments may be any integer type, float, double, bool or char; strings
+   are not supported, since the pointer may be gone by the time the record
+   is sent.  Each argument takes a five-byte slot, a type tag and four
+   bytes, except that a 64-bit integer (long long, or long on a 64-bit host)
+   takes two, and a record may have at most sixteen slots.  A record that does not fit in the buffer is dropped whole and
+   counted.  The logger is not safe to call from interrupt handlers.
+
+   Each RFTPure keeps its own ring and selects it for the calling thread
+   when it is constructed and on every begin() and update(), so several
+   firmware objects, as in the SITL runner, don't share one.  Records made
+   before any firmware exists go to a ring of their own.
+
+   Define RFT_LOG_BUFSIZE (a power of two, default 256) before including
+   this file to change the size of the buffer.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "RFT_footprint.hpp"
+
+#ifndef RFT_LOG_BUFSIZE
+#define RFT_LOG_BUFSIZE 256
+#endif
+
+// Which firmware's rings are in use is kept per thread on the host, where
+// the SITL runner steps vehicles on several threads
+#ifndef RFT_THREAD_LOCAL
+#ifdef ARDUINO
+#define RFT_THREAD_LOCAL
+#else
+#define RFT_THREAD_LOCAL thread_local
+#endif
+#endif
+
+#define RFT_LOG_FORMAT(fmt, ...) fmt
+
+// The template argument forces the hash to be computed by the compiler
+#define RFT_LOG(...) \
+    rft::Logger::record(rft::LogId<rft::Logger::formatId( \
+                RFT_LOG_FORMAT(__VA_ARGS__, 0))>::value, __VA_ARGS__)
+
+namespace rft {
+
+    template <uint16_t ID> struct LogId {
+
+        static const uint16_t value = ID;
+    };
+
+    // Slots each argument type takes in a record
+    template <typename T> struct LogSlots {
+
+        static const uint8_t value = 1;
+    };
+
+    template <> struct LogSlots<long> {
+
+        static const uint8_t value = sizeof(long) / 4;
+    };
+
+    template <> struct LogSlots<unsigned long> {
+
+        static const uint8_t value = sizeof(unsigned long) / 4;
+    };
+
+    template <> struct LogSlots<long long> {
+
+        static const uint8_t value = 2;
+    };
+
+    template <> struct LogSlots<unsigned long long> {
+
+        static const uint8_t value = 2;
+    };
+
+    template <typename... Args> struct LogSlotCount {
+
+        static const uint8_t value = 0;
+    };
+
+    template <typename T, typename... Rest> struct LogSlotCount<T, Rest...> {
+
+        static const uint8_t value =
+            LogSlots<T>::value + LogSlotCount<Rest...>::value;
+    };
+
+    class Logger {
+
+        public:
+
+            // Constant-initialized, so no guard on first use
+            struct Ring {
+                uint8_t buf[RFT_LOG_BUFSIZE];
+                uint16_t head;
+                uint16_t tail;
+                uint32_t dropped;
+                uint32_t reported;
+                uint16_t highWater;
+            };
+
+        private:
+
+            static const uint16_t MASK = RFT_LOG_BUFSIZE - 1;
+
+            static_assert((RFT_LOG_BUFSIZE & MASK) == 0,
+                    "RFT_LOG_BUFSIZE must be a power of two");
+
+            // Record header: format ID (little-endian) and total size
+            static const uint8_t HEADER_SIZE = 3;
+
+            // Each slot is a type tag followed by four bytes
+            static const uint8_t ARG_SIZE = 5;
+
+            static Ring *& selected(void)
+            {
+                static RFT_THREAD_LOCAL Ring * r = NULL;
+                return r;
+            }
+
+            static Ring & ring(void)
+            {
+                static Ring unselected;
+                Ring * r = selected();
+                return r ? *r : unselected;
+            }
+
+            static constexpr uint32_t fnv1a(const char * s, uint32_t h)
+            {
+                return *s ? fnv1a(s+1, (h ^ (uint8_t)*s) * 16777619u) : h;
+            }
+
+            static constexpr uint16_t fold(uint32_t h)
+            {
+                // Zero is reserved for the dropped-records notice
+                return (uint16_t)(h ^ (h >> 16)) ? (uint16_t)(h ^ (h >> 16)) : 1;
+            }
+
+            static void put(Ring & r, uint16_t & pos, uint8_t c)
+            {
+                r.buf[pos++ & MASK] = c;
+            }
+
+            static void put(Ring & r, uint16_t & pos, char tag, uint32_t bits)
+            {
+                put(r, pos, (uint8_t)tag);
+                put(r, pos, bits);
+                put(r, pos, bits >> 8);
+                put(r, pos, bits >> 16);
+                put(r, pos, bits >> 24);
+            }
+
+            static uint32_t bits(float value)
+            {
+                uint32_t b = 0;
+                memcpy(&b, &value, 4);
+                return b;
+            }
+
+            // One overload per fundamental type, so that the fixed-width
+            // typedefs resolve on every platform
+            static void arg(Ring & r, uint16_t & p, bool v) { put(r, p, 'u', v); }
+            static void arg(Ring & r, uint16_t & p, char v) { put(r, p, 'c', (uint8_t)v); }
+            static void arg(Ring & r, uint16_t & p, signed char v) { put(r, p, 'i', (int32_t)v); }
+            static void arg(Ring & r, uint16_t & p, unsigned char v) { put(r, p, 'u', v); }
+            static void arg(Ring & r, uint16_t & p, short v) { put(r, p, 'i', (int32_t)v); }
+            static void arg(Ring & r, uint16_t & p, unsigned short v) { put(r, p, 'u', v); }
+            static void arg(Ring & r, uint16_t & p, int v) { put(r, p, 'i', (int32_t)v); }
+            static void arg(Ring & r, uint16_t & p, unsigned int v) { put(r, p, 'u', v); }
+            static void arg(Ring & r, uint16_t & p, long v) { arg(r, p, (long long)v, LogSlots<long>::value); }
+            static void arg(Ring & r, uint16_t & p, unsigned long v) { arg(r, p, (unsigned long long)v, LogSlots<unsigned long>::value); }
+            static void arg(Ring & r, uint16_t & p, long long v) { arg(r, p, v, 2); }
+            static void arg(Ring & r, uint16_t & p, unsigned long long v) { arg(r, p, v, 2); }
+            static void arg(Ring & r, uint16_t & p, float v) { put(r, p, 'f', bits(v)); }
+            static void arg(Ring & r, uint16_t & p, double v) { put(r, p, 'f', bits(v)); }
+
+            // Sixty-four bits go as the low word, tagged 'q' or 'Q', then
+            // the high word, tagged 'h'
+            static void arg(Ring & r, uint16_t & p, long long v, uint8_t slots)
+            {
+                if (slots == 1) {
+                    put(r, p, 'i', (int32_t)v);
+                    return;
+                }
+                put(r, p, 'q', (uint32_t)v);
+                put(r, p, 'h', (uint32_t)((unsigned long long)v >> 32));
+            }
+
+            static void arg(Ring & r, uint16_t & p, unsigned long long v,
+                            uint8_t slots)
+            {
+                if (slots == 1) {
+                    put(r, p, 'u', (uint32_t)v);
+                    return;
+                }
+                put(r, p, 'Q', (uint32_t)v);
+                put(r, p, 'h', (uint32_t)(v >> 32));
+            }
+
+            static void args(Ring & r, uint16_t & p)
+            {
+                (void)r;
+                (void)p;
+            }
+
+            template <typename T, typename... Rest>
+            static void args(Ring & r, uint16_t & p, T first, Rest... rest)
+            {
+                arg(r, p, first);
+                args(r, p, rest...);
+            }
+
+        public:
+
+            // MultiWii's debug-message ID
+            static const uint8_t MSP_ID = 253;
+
+            // Sends this thread's records to ring from now on
+            static void select(Ring & ring)
+            {
+                selected() = &ring;
+            }
+
+            static constexpr uint16_t formatId(const char * fmt)
+            {
+                return fold(fnv1a(fmt, 2166136261u));
+            }
+
+            template <typename... Args>
+            static void record(uint16_t id, const char * fmt, Args... values)
+            {
+                (void)fmt;
+
+                static const uint8_t slots = LogSlotCount<Args...>::value;
+
+                static const uint8_t size = HEADER_SIZE + ARG_SIZE * slots;
+
+                static_assert(slots <= 16,
+                        "too many log arguments (64-bit ones count twice)");
+
+                Ring & r = ring();
+
+                if ((uint16_t)(RFT_LOG_BUFSIZE - (uint16_t)(r.head - r.tail)) < size) {
+                    r.dropped++;
+                    return;
+                }
+
+                uint16_t p = r.head;
+                put(r, p, id);
+                put(r, p, id >> 8);
+                put(r, p, size);
+                args(r, p, values...);
+
+                r.head = p;
+
+                uint16_t used = r.head - r.tail;
+                r.highWater = used > r.highWater ? used : r.highWater;
+            }
+
+            // Copies as many whole records as fit in max bytes, preceded by a
+            // notice if any were dropped since the last call; returns the
+            // number of bytes copied
+            static uint8_t drain(uint8_t * dst, uint8_t max)
+            {
+                Ring & r = ring();
+
+                uint8_t n = 0;
+
+                if (r.dropped != r.reported && max >= HEADER_SIZE + ARG_SIZE) {
+                    uint32_t count = r.dropped - r.reported;
+                    dst[n++] = 0;
+                    dst[n++] = 0;
+                    dst[n++] = HEADER_SIZE + ARG_SIZE;
+                    dst[n++] = 'u';
+                    for (uint8_t k=0; k<4; ++k) {
+                        dst[n++] = count >> (8*k);
+                    }
+                    r.reported = r.dropped;
+                }
+
+                // In locals, since dst might alias the ring for all the
+                // compiler knows
+                uint16_t tail = r.tail;
+                const uint16_t head = r.head;
+
+                while (tail != head) {
+
+                    uint8_t size = r.buf[(tail + 2) & MASK];
+
+                    if (n + size > max) {
+                        break;
+                    }
+
+                    for (uint8_t k=0; k<size; ++k) {
+                        dst[n++] = r.buf[tail++ & MASK];
+                    }
+                }
+
+                r.tail = tail;
+
+                return n;
+            }
+
+            static uint16_t pending(void)
+            {
+                return ring().head - ring().tail;
+            }
+
+            static uint32_t dropped(void)
+            {
+                return ring().dropped;
+            }
+
+            static void addFootprint(Footprint & footprint)
+            {
+                footprint.add("Logger", sizeof(Ring), RFT_LOG_BUFSIZE,
+                        &ring().highWater);
+            }
+
+    }; // class Logger
+
+} // namespace rft
@@ -0,0 +1,257 @@
+/*
+   Compile-time MSP message definitions
+
+   A message is declared as its ID and the types of its fields:
+
+       typedef rft::MspMessage<122, float, float, float> ATTITUDE;
+
+   and the compiler derives the payload size, the offset of every field, and
+   code to serialize and deserialize it, so a sender and receiver built from
+   the same declaration cannot disagree about the layout.  Fields may be
+   uint8_t, int16_t, int32_t or float, as in messages.json; anything else
+   fails to compile.  MspDispatcher<...> routes an incoming payload to the
+   handler overload for its message type.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+namespace rft {
+
+    // Wire size of each supported field type
+    template <typename T> struct MspField;
+
+    template <> struct MspField<uint8_t> { static const uint8_t SIZE = 1; };
+    template <> struct MspField<int16_t> { static const uint8_t SIZE = 2; };
+    template <> struct MspField<int32_t> { static const uint8_t SIZE = 4; };
+    template <> struct MspField<float>   { static const uint8_t SIZE = 4; };
+
+    // Sum of the field sizes
+    template <typename... Fields> struct MspPayloadSize {
+
+        static const uint16_t value = 0;
+    };
+
+    template <typename T, typename... Rest>
+    struct MspPayloadSize<T, Rest...> {
+
+        static const uint16_t value =
+            MspField<T>::SIZE + MspPayloadSize<Rest...>::value;
+    };
+
+    // Type and offset of field I
+    template <uint8_t I, typename... Fields> struct MspFieldAt;
+
+    template <typename T, typename... Rest>
+    struct MspFieldAt<0, T, Rest...> {
+
+        typedef T type;
+        static const uint8_t offset = 0;
+    };
+
+    template <uint8_t I, typename T, typename... Rest>
+    struct MspFieldAt<I, T, Rest...> {
+
+        typedef typename MspFieldAt<I-1, Rest...>::type type;
+        static const uint8_t offset =
+            MspField<T>::SIZE + MspFieldAt<I-1, Rest...>::offset;
+    };
+
+    // Compile-time index lists, for unpacking a payload into arguments
+    template <uint8_t... I> struct MspIndices { };
+
+    template <uint8_t N, uint8_t... I>
+    struct MspMakeIndices : MspMakeIndices<N-1, N-1, I...> { };
+
+    template <uint8_t... I>
+    struct MspMakeIndices<0, I...> {
+
+        typedef MspIndices<I...> type;
+    };
+
+    class MspCodec {
+
+        template <uint8_t MSGID, typename... Fields> friend class MspMessage;
+
+        private:
+
+            // Little-endian, whatever the host
+            static void put(uint8_t * buf, uint8_t value)
+            {
+                buf[0] = value;
+            }
+
+            static void put(uint8_t * buf, int16_t value)
+            {
+                buf[0] = value;
+                buf[1] = value >> 8;
+            }
+
+            static void put(uint8_t * buf, int32_t value)
+            {
+                for (uint8_t k=0; k<4; ++k) {
+                    buf[k] = value >> (8*k);
+                }
+            }
+
+            static void put(uint8_t * buf, float value)
+            {
+                int32_t bits = 0;
+                memcpy(&bits, &value, 4);
+                put(buf, bits);
+            }
+
+            static void get(const uint8_t * buf, uint8_t & value)
+            {
+                value = buf[0];
+            }
+
+            static void get(const uint8_t * buf, int16_t & value)
+            {
+                value = (int16_t)(buf[0] | buf[1] << 8);
+            }
+
+            static void get(const uint8_t * buf, int32_t & value)
+            {
+                value = (int32_t)((uint32_t)buf[0] | (uint32_t)buf[1] << 8 |
+                        (uint32_t)buf[2] << 16 | (uint32_t)buf[3] << 24);
+            }
+
+            static void get(const uint8_t * buf, float & value)
+            {
+                int32_t bits = 0;
+                get(buf, bits);
+                memcpy(&value, &bits, 4);
+            }
+
+            template <typename T>
+            static T read(const uint8_t * buf)
+            {
+                T value;
+                get(buf, value);
+                return value;
+            }
+
+            static void putAll(uint8_t * buf)
+            {
+                (void)buf;
+            }
+
+            template <typename T, typename... Rest>
+            static void putAll(uint8_t * buf, T value, Rest... rest)
+            {
+                put(buf, value);
+                putAll(buf + MspField<T>::SIZE, rest...);
+            }
+
+            static void getAll(const uint8_t * buf)
+            {
+                (void)buf;
+            }
+
+            template <typename T, typename... Rest>
+            static void getAll(const uint8_t * buf, T & value, Rest & ... rest)
+            {
+                get(buf, value);
+                getAll(buf + MspField<T>::SIZE, rest...);
+            }
+
+    }; // class MspCodec
+
+    template <uint8_t MSGID, typename... Fields> class MspMessage {
+
+        private:
+
+            template <typename Handler, uint8_t... I>
+            static void call(Handler & handler, const uint8_t * payload,
+                             MspIndices<I...>)
+            {
+                (void)payload;
+                handler.handle(MspMessage(), MspCodec::read<
+                        typename MspFieldAt<I, Fields...>::type>(
+                            payload + MspFieldAt<I, Fields...>::offset)...);
+            }
+
+        public:
+
+            static const uint8_t ID = MSGID;
+
+            static const uint8_t FIELD_COUNT = sizeof...(Fields);
+
+            static const uint16_t PAYLOAD_SIZE = MspPayloadSize<Fields...>::value;
+
+            static_assert(PAYLOAD_SIZE <= 255, "MSP payload too large");
+
+            // Writes the payload, PAYLOAD_SIZE bytes
+            static void serialize(uint8_t * payload, Fields... values)
+            {
+                MspCodec::putAll(payload, values...);
+            }
+
+            static void deserialize(const uint8_t * payload, Fields & ... values)
+            {
+                MspCodec::getAll(payload, values...);
+            }
+
+            // Calls handler.handle(MspMessage(), fields...)
+            template <typename Handler>
+            static void dispatch(Handler & handler, const uint8_t * payload)
+            {
+                call(handler, payload,
+                     typename MspMakeIndices<sizeof...(Fields)>::type());
+            }
+
+    }; // class MspMessage
+
+    // Routes a payload to the handler overload for its message; returns
+    // false for an unknown ID or a payload of the wrong size
+    template <typename... Messages> class MspDispatcher {
+
+        public:
+
+            template <typename Handler>
+            static bool dispatch(Handler & handler, uint8_t id,
+                                 const uint8_t * payload, uint8_t size)
+            {
+                (void)handler;
+                (void)id;
+                (void)payload;
+                (void)size;
+                return false;
+            }
+
+    }; // class MspDispatcher
+
+    template <typename M, typename... Rest>
+    class MspDispatcher<M, Rest...> {
+
+        public:
+
+            template <typename Handler>
+            static bool dispatch(Handler & handler, uint8_t id,
+                                 const uint8_t * payload, uint8_t size)
+            {
+                if (id == M::ID) {
+
+                    if (size != M::PAYLOAD_SIZE) {
+                        return false;
+                    }
+
+                    M::dispatch(handler, payload);
+
+                    return true;
+                }
+
+                return MspDispatcher<Rest...>::dispatch(handler, id,
+                                                        payload, size);
+            }
+
+    }; // class MspDispatcher
+
+} // namespace rft
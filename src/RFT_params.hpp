@@ -0,0 +1,323 @@
+/*
+   Persistent parameters
+
+   ParameterStore keeps tunable values (gains, filter constants, rates) in
+   one flat image: a header, then a four-byte slot for each parameter in the
+   order they were added.  The board stores the image byte for byte, so
+   loading it at startup is one block copy followed by a check of the header
+   and checksum, whatever the number of parameters:
+
+       static ParameterStore parameters;
+
+       static const int8_t ROLL_KP =
+           parameters.addFloat("pid.roll.kp", 0.2f, 0, 10);
+       ...
+       parameters.begin(board);   // stored values, or the defaults
+
+       float kp = parameters.getFloat(ROLL_KP);
+
+   A stored image is used only if its layout, i.e. the names, types and
+   order of the parameters, matches the firmware's; adding, removing or
+   retyping a parameter brings back the defaults instead of misreading the
+   old values.  Code that derives something from a parameter can compare
+   changes() with the value it last saw, rather than recomputing every tick.
+
+   The MSP messages PARAM_GET, PARAM_SET and PARAM_SAVE (see
+   extras/parser/messages.json) read, change and store parameters by index;
+   SerialTask answers them.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "RFT_board.hpp"
+#include "RFT_footprint.hpp"
+
+#ifndef RFT_PARAM_MAX
+#define RFT_PARAM_MAX 32
+#endif
+
+namespace rft {
+
+    class ParameterStore {
+
+        public:
+
+            static const uint8_t MAX = RFT_PARAM_MAX;
+
+            static_assert(MAX <= 127, "indices must fit in an int8_t");
+
+            enum {
+                FLOAT,
+                INT
+            };
+
+        private:
+
+            static const uint32_t MAGIC = 0x50544652; // "RFTP"
+
+            // Bumped when the header or slot format changes
+            static const uint16_t FORMAT = 1;
+
+            static const uint32_t FNV_BASIS = 2166136261u;
+            static const uint32_t FNV_PRIME = 16777619u;
+
+            typedef struct {
+
+                uint32_t magic;
+                uint16_t format;
+                uint16_t count;
+                uint32_t layout;
+                uint32_t checksum;
+
+            } header_t;
+
+            // Exactly what is stored, header first
+            struct {
+
+                header_t header;
+                uint32_t slots[MAX];
+
+            } _image = {};
+
+            uint32_t _defaults[MAX] = {};
+            float _minimum[MAX] = {};
+            float _maximum[MAX] = {};
+            const char * _names[MAX] = {};
+            uint8_t _types[MAX] = {};
+
+            uint8_t _count = 0;
+
+            // Hash of the names and types, in order
+            uint32_t _layout = FNV_BASIS;
+
+            uint16_t _changes = 0;
+
+            Board * _board = NULL;
+
+            static uint32_t hash(const char * s, uint32_t h)
+            {
+                for (; *s; ++s) {
+                    h = (h ^ (uint8_t)*s) * FNV_PRIME;
+                }
+                return h;
+            }
+
+            uint32_t checksum(void)
+            {
+                uint32_t h = FNV_BASIS;
+                for (uint8_t k=0; k<_count; ++k) {
+                    h = (h ^ _image.slots[k]) * FNV_PRIME;
+                }
+                return h;
+            }
+
+            uint16_t imageSize(void)
+            {
+                return sizeof(header_t) + _count * sizeof(uint32_t);
+            }
+
+            void stamp(void)
+            {
+                _image.header.magic = MAGIC;
+                _image.header.format = FORMAT;
+                _image.header.count = _count;
+                _image.header.layout = _layout;
+                _image.header.checksum = checksum();
+            }
+
+            bool valid(void)
+            {
+                const header_t & h = _image.header;
+
+                return h.magic == MAGIC && h.format == FORMAT &&
+                    h.count == _count && h.layout == _layout &&
+                    h.checksum == checksum();
+            }
+
+            int8_t addSlot(const char * name, uint8_t type, uint32_t bits,
+                    float minimum, float maximum)
+            {
+                if (_count == MAX) {
+                    return -1;
+                }
+
+                _names[_count] = name;
+                _types[_count] = type;
+                _defaults[_count] = bits;
+                _image.slots[_count] = bits;
+                _minimum[_count] = minimum;
+                _maximum[_count] = maximum;
+
+                _layout = (hash(name, _layout) ^ type) * FNV_PRIME;
+
+                return _count++;
+            }
+
+        public:
+
+            // Each returns the new parameter's index, or -1 if the store is
+            // full; add all parameters before begin()
+
+            int8_t addFloat(const char * name, float value, float minimum,
+                    float maximum)
+            {
+                uint32_t bits = 0;
+                memcpy(&bits, &value, 4);
+                return addSlot(name, FLOAT, bits, minimum, maximum);
+            }
+
+            int8_t addInt(const char * name, int32_t value, int32_t minimum,
+                    int32_t maximum)
+            {
+                return addSlot(name, INT, (uint32_t)value, minimum, maximum);
+            }
+
+            // Loads the stored values from the board, or the defaults if
+            // there are none for this layout; returns true if stored values
+            // were loaded
+            bool begin(Board * board)
+            {
+                _board = board;
+
+                return load();
+            }
+
+            bool load(void)
+            {
+                // One copy straight into the live image, then the check
+                if (_board &&
+                        _board->storageRead(&_image, imageSize()) && valid()) {
+                    _changes++;
+                    return true;
+                }
+
+                restoreDefaults();
+                return false;
+            }
+
+            bool save(void)
+            {
+                stamp();
+
+                return _board && _board->storageWrite(&_image, imageSize());
+            }
+
+            void restoreDefaults(void)
+            {
+                memcpy(_image.slots, _defaults, _count * sizeof(uint32_t));
+                stamp();
+                _changes++;
+            }
+
+            // Clamps the value to the parameter's range, rounding it for an
+            // integer parameter; returns false for a bad index or a value
+            // that is NaN or infinite, which the clamp would let through
+            // or turn into a limit
+            bool set(uint8_t index, float value)
+            {
+                if (index >= _count || value != value || value - value != 0) {
+                    return false;
+                }
+
+                value = value < _minimum[index] ? _minimum[index]
+                    : value > _maximum[index] ? _maximum[index]
+                    : value;
+
+                if (_types[index] == INT) {
+                    int32_t i = (int32_t)(value + (value < 0 ? -0.5f : 0.5f));
+                    _image.slots[index] = (uint32_t)i;
+                }
+
+                else {
+                    memcpy(&_image.slots[index], &value, 4);
+                }
+
+                _changes++;
+
+                return true;
+            }
+
+            float getFloat(uint8_t index)
+            {
+                if (_types[index] == INT) {
+                    return (float)getInt(index);
+                }
+
+                float value = 0;
+                memcpy(&value, &_image.slots[index], 4);
+                return value;
+            }
+
+            int32_t getInt(uint8_t index)
+            {
+                return (int32_t)_image.slots[index];
+            }
+
+            uint8_t count(void)
+            {
+                return _count;
+            }
+
+            uint8_t type(uint8_t index)
+            {
+                return _types[index];
+            }
+
+            const char * name(uint8_t index)
+            {
+                return _names[index];
+            }
+
+            // FNV-1a hash of the name, which identifies a parameter over
+            // MSP
+            uint32_t nameHash(uint8_t index)
+            {
+                return hash(_names[index], FNV_BASIS);
+            }
+
+            float minimum(uint8_t index)
+            {
+                return _minimum[index];
+            }
+
+            float maximum(uint8_t index)
+            {
+                return _maximum[index];
+            }
+
+            uint32_t layout(void)
+            {
+                return _layout;
+            }
+
+            uint32_t currentChecksum(void)
+            {
+                return checksum();
+            }
+
+            // Incremented by every load, set and reset; wraps around
+            uint16_t changes(void)
+            {
+                return _changes;
+            }
+
+            void addFootprint(Footprint & footprint)
+            {
+                // Slot, default, range, name and type of each parameter
+                static const uint16_t PER_PARAMETER = 2 * sizeof(uint32_t) +
+                    2 * sizeof(float) + sizeof(const char *) + sizeof(uint8_t);
+
+                footprint.add("ParameterStore", sizeof(*this), MAX, &_count,
+                        PER_PARAMETER);
+            }
+
+    }; // class ParameterStore
+
+} // namespace rft
@@ -12,6 +12,9 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "RFT_footprint.hpp"
+#include "RFT_messages.hpp"
+
 namespace rft {
 
     class Parser {
@@ -22,10 +25,23 @@ namespace rft {
 
             static const int OUTBUF_SIZE = 128;
 
-            uint8_t _outBufChecksum;
-            uint8_t _outBuf[OUTBUF_SIZE];
-            uint8_t _outBufIndex;
-            uint8_t _outBufSize;
+            uint8_t _outBufChecksum = 0;
+            uint8_t _outBuf[OUTBUF_SIZE] = {};
+            uint8_t _outBufIndex = 0;
+            uint8_t _outBufSize = 0;
+
+            // Longest message sent
+            uint8_t _outBufHighWater = 0;
+
+            // Parser state, kept per instance so that several parsers can
+            // run side by side
+            uint8_t _parserState = 0;
+            uint8_t _type = 0;
+            uint8_t _crc = 0;
+            uint8_t _size = 0;
+
+            // Counts past a full payload of 255 bytes to its checksum
+            uint16_t _index = 0;
 
             void serialize16(int16_t a)
             {
@@ -61,9 +77,22 @@ namespace rft {
 
         protected:
 
+            // Longest incoming payload accepted; the buffers behind
+            // collectPayload(), like the one msppg generates, hold this many
+            static const uint8_t MAX_PAYLOAD = 128;
+
             void completeSend(void)
             {
                 serialize8(_outBufChecksum);
+
+                _outBufHighWater = _outBufSize > _outBufHighWater ?
+                    _outBufSize : _outBufHighWater;
+            }
+
+            void addFootprint(Footprint & footprint, const char * name,
+                    uint32_t size)
+            {
+                footprint.add(name, size, OUTBUF_SIZE, &_outBufHighWater);
             }
 
             void serialize8(uint8_t a)
@@ -118,6 +147,23 @@ namespace rft {
                 serialize32(a);
             }
 
+            // Sends message M, with its layout checked at compile time
+            template <typename M, typename... Args>
+            void sendMessage(Args... values)
+            {
+                static_assert(M::PAYLOAD_SIZE <= OUTBUF_SIZE - 6,
+                        "message too large for the output buffer");
+
+                uint8_t payload[M::PAYLOAD_SIZE > 0 ? M::PAYLOAD_SIZE : 1];
+                M::serialize(payload, values...);
+
+                prepareToSendBytes(M::ID, M::PAYLOAD_SIZE);
+                for (uint8_t k=0; k<M::PAYLOAD_SIZE; ++k) {
+                    serialize8(payload[k]);
+                }
+                completeSend();
+            }
+
             virtual void collectPayload(uint8_t index, uint8_t value) = 0;
             virtual void dispatchMessage(uint8_t type) = 0;
 
@@ -150,46 +196,46 @@ namespace rft {
                     IN_PAYLOAD
                 }; 
 
-                static uint8_t parser_state;
-
-                static uint8_t type;
-                static uint8_t crc;
-                static uint8_t size;
-                static uint8_t index;
-
                 // Payload functions
-                size = parser_state == GOT_ARROW ? c : size;
-                index = parser_state == IN_PAYLOAD ? index + 1 : 0;
-                bool incoming = type >= 200;
-                bool in_payload = incoming && parser_state == IN_PAYLOAD;
+                _size = _parserState == GOT_ARROW ? c : _size;
+                _index = _parserState == IN_PAYLOAD ? _index + 1 : 0;
+                bool incoming = _type >= 200;
+                bool in_payload = incoming && _parserState == IN_PAYLOAD &&
+                    _index <= _size;
+
+                // The checksum byte follows the payload
+                bool at_checksum = _parserState == IN_PAYLOAD && _index > _size;
 
                 // Command acquisition function
-                type = parser_state == GOT_SIZE ? c : type;
+                _type = _parserState == GOT_SIZE ? c : _type;
 
-                // Checksum transition function
-                crc = parser_state == GOT_ARROW ? c
-                    : parser_state == IN_PAYLOAD  ?  crc ^ c 
+                // Checksum transition function: XOR of size, type and payload
+                uint8_t expected = _crc;
+                _crc = _parserState == GOT_ARROW ? c
+                    : _parserState == GOT_SIZE ? _crc ^ c
+                    : _parserState == IN_PAYLOAD  ?  _crc ^ c 
                     : 0;
 
                 // Parser state transition function
-                parser_state
-                    = parser_state == IDLE && c == '$' ? GOT_START
-                    : parser_state == GOT_START && c == 'M' ? GOT_M
-                    : parser_state == GOT_M && (c == '<' || c == '>') ? GOT_ARROW
-                    : parser_state == GOT_ARROW ? GOT_SIZE
-                    : parser_state == GOT_SIZE ? IN_PAYLOAD
-                    : parser_state == IN_PAYLOAD && index < size ? IN_PAYLOAD
-                    : parser_state == IN_PAYLOAD ? IDLE
-                    : parser_state;
+                _parserState
+                    = _parserState == IDLE && c == '$' ? GOT_START
+                    : _parserState == GOT_START && c == 'M' ? GOT_M
+                    : _parserState == GOT_M && (c == '<' || c == '>') ? GOT_ARROW
+                    : _parserState == GOT_ARROW && c <= MAX_PAYLOAD ? GOT_SIZE
+                    : _parserState == GOT_ARROW ? IDLE
+                    : _parserState == GOT_SIZE ? IN_PAYLOAD
+                    : _parserState == IN_PAYLOAD && !at_checksum ? IN_PAYLOAD
+                    : _parserState == IN_PAYLOAD ? IDLE
+                    : _parserState;
 
                 // Payload accumulation
                 if (in_payload) {
-                    collectPayload(index-1, c);
+                    collectPayload(_index-1, c);
                 }
 
                 // Message dispatch
-                if (parser_state == IDLE && crc == c) {
-                    dispatchMessage(type);
+                if (at_checksum && expected == c) {
+                    dispatchMessage(_type);
                 }
 
             } // parse
@@ -15,6 +15,12 @@
 #include "RFT_actuator.hpp"
 #include "RFT_parser.hpp"
 #include "RFT_closedlooptask.hpp"
+#include "RFT_footprint.hpp"
+#include "RFT_debugger.hpp"
+#include "RFT_logger.hpp"
+#include "RFT_params.hpp"
+#include "RFT_scheduler.hpp"
+#include "RFT_watchdog.hpp"
 
 namespace rft {
 
@@ -22,9 +28,25 @@ namespace rft {
 
         private:
 
+            // Startup: begin() starts everything without waiting, then
+            // update() polls the board, sensors and actuator until all are
+            // ready, flashing the LED meanwhile
+            enum {
+                STARTING,
+                RUNNING
+            };
+
+            uint8_t _stage = STARTING;
+            float _beginTime = 0;
+            float _readyTime = 0;
+
             // Safety
             bool _safeToArm = false;
 
+            // Set when the setup was rejected, e.g. a closed-loop controller
+            // that could not be added; the firmware then never starts
+            const char * _setupError = NULL;
+
             // Sensors 
             Sensor * _sensors[256] = {};
             uint8_t _sensor_count = 0;
@@ -32,6 +54,91 @@ namespace rft {
             // Timer task for PID controllers
             ClosedLoopTask _closedLoopTask;
 
+            // RAM use of this firmware, reported by its serial tasks
+            Footprint _footprint;
+
+            // Debugger::printf() and RFT_LOG() output of this firmware,
+            // selected whenever it runs
+            Debugger::Ring _debugRing = {};
+            Logger::Ring _logRing = {};
+
+            void selectRings(void)
+            {
+                Debugger::select(_debugRing);
+                Logger::select(_logRing);
+            }
+
+            // Tunable values, loaded from the board's storage at startup
+            ParameterStore * _parameters = NULL;
+
+            // Signal-loss failsafe, also checked from a board timer if any
+            Watchdog _watchdog;
+            volatile bool _armed = false;
+            volatile bool _signalCut = false;
+
+            static void watchdogTimer(void * context)
+            {
+                RFTPure * rft = (RFTPure *)context;
+                rft->checkWatchdog(rft->_board->getTime());
+            }
+
+            void checkWatchdog(float time)
+            {
+                if (_armed && !_signalCut && _watchdog.expired(time)) {
+                    cutForSignalLoss(time);
+                }
+            }
+
+            void cutForSignalLoss(float time)
+            {
+                _signalCut = true;
+                _actuator->cut();
+                _watchdog.record(time);
+            }
+
+            static bool closedLoopTask(void * context, uint8_t index)
+            {
+                (void)index;
+
+                RFTPure * rft = (RFTPure *)context;
+
+                rft->_footprint.sampleStack();
+
+                // Motors aren't used until startup is done, nor after the
+                // watchdog has cut them, which the timer can do after this
+                // pass has checked the open-loop controller, or during the
+                // tick
+                if (rft->_stage == RUNNING && !rft->_signalCut) {
+
+                    rft->_closedLoopTask.run(rft->_board, rft->_olc,
+                                             rft->_actuator, rft->_state,
+                                             &rft->_signalCut);
+
+                    // Or while the motors were being run
+                    if (rft->_signalCut) {
+                        rft->_actuator->cut();
+                    }
+                }
+
+                return true;
+            }
+
+            static bool sensorTask(void * context, uint8_t index)
+            {
+                (void)index;
+
+                RFTPure * rft = (RFTPure *)context;
+
+                rft->_footprint.sampleStack();
+
+                // Nor are sensors, which may still be calibrating
+                if (rft->_stage == RUNNING) {
+                    rft->checkSensors(rft->_state);
+                }
+
+                return true;
+            }
+
             void startSensors(void) 
             {
                 for (uint8_t k=0; k<_sensor_count; ++k) {
@@ -39,6 +146,49 @@ namespace rft {
                 }
             }
 
+            void checkStartup(void)
+            {
+                float time = _board->getTime();
+
+                // Everything is polled on every pass, so calibrations and
+                // settling times overlap instead of adding up
+                bool ready = _board->ready(time);
+
+                for (uint8_t k=0; k<_sensor_count; ++k) {
+                    ready = _sensors[k]->ready(time) && ready;
+                }
+
+                ready = _actuator->ready(time) && ready;
+
+                if (ready && !_setupError) {
+                    _stage = RUNNING;
+                    _readyTime = time;
+                    _board->showArmedStatus(false);
+                }
+
+                else {
+                    _board->showStartingStatus();
+                }
+            }
+
+            void addFootprint(void)
+            {
+                // Less the members that register themselves
+                _footprint.add("RFTPure", sizeof(*this) -
+                        sizeof(ClosedLoopTask) - sizeof(Scheduler) -
+                        sizeof(Debugger::Ring) - sizeof(Logger::Ring),
+                        256, &_sensor_count, sizeof(Sensor *));
+
+                Debugger::addFootprint(_footprint);
+                Logger::addFootprint(_footprint);
+                _closedLoopTask.addFootprint(_footprint);
+                _scheduler.addFootprint(_footprint);
+
+                if (_parameters) {
+                    _parameters->addFootprint(_footprint);
+                }
+            }
+
             void checkSensors(State * state)
             {
                 // Some sensors may need to know the current time
@@ -51,11 +201,19 @@ namespace rft {
 
             void checkOpenLoopController(State * state)
             {
+                float time = _board->getTime();
+
+                // Enforce the signal deadline, if the timer hasn't already
+                checkWatchdog(time);
+
                 // Sync failsafe to open-loop-controller
-                if (_olc->lostSignal() && state->armed) {
-                    _actuator->cut();
+                if ((_olc->lostSignal() || _signalCut) && state->armed) {
+                    if (!_signalCut) {
+                        cutForSignalLoss(time);
+                    }
                     state->armed = false;
                     state->failsafe = true;
+                    _armed = false;
                     _board->showArmedStatus(false);
                     return;
                 }
@@ -63,6 +221,8 @@ namespace rft {
                 // Check whether controller data is available
                 if (!_olc->ready()) return;
 
+                _watchdog.feed(time);
+
                 // Disarm
                 if (state->armed && !_olc->inArmedState()) {
                     state->armed = false;
@@ -74,7 +234,8 @@ namespace rft {
                 }
 
                 // Arm after lots of safety checks
-                if (_safeToArm
+                if (_stage == RUNNING
+                    && _safeToArm
                     && !state->armed
                     && !state->failsafe 
                     && state->safeToArm()
@@ -89,8 +250,13 @@ namespace rft {
                     _actuator->cut();
                 }
 
-                // Set LED based on arming status
-                _board->showArmedStatus(state->armed);
+                _armed = state->armed;
+
+                // Set LED based on arming status, once it's done showing
+                // startup
+                if (_stage == RUNNING) {
+                    _board->showArmedStatus(state->armed);
+                }
 
             } // checkOpenLoopController
 
@@ -101,6 +267,12 @@ namespace rft {
             OpenLoopController * _olc = NULL;
             Actuator * _actuator = NULL;
 
+            // Periodic tasks, run by deadline and priority from update()
+            Scheduler _scheduler;
+
+            // State for the scheduled tasks, as of this update
+            State * _state = NULL;
+
             RFTPure(Board * board,
                     OpenLoopController * olc,
                     Actuator * actuator)
@@ -110,13 +282,34 @@ namespace rft {
                 _actuator = actuator;
 
                 _sensor_count = 0;
+
+                // So that messages from the sketch's setup() are ours
+                selectRings();
+
+                _scheduler.add(closedLoopTask, this, 0,
+                               _closedLoopTask.period(), Scheduler::CONTROL);
             }
 
+            // Starts the board and devices and returns; update() finishes
+            // the startup
             void begin(void)
             {  
+                selectRings();
+
+                addFootprint();
+
                 // Start the board
                 _board->begin();
 
+                if (_setupError) {
+                    _board->error(_setupError);
+                }
+
+                // Stored parameters, before anything that uses them starts
+                if (_parameters) {
+                    _parameters->begin(_board);
+                }
+
                 // Initialize the sensors
                 startSensors();
 
@@ -126,31 +319,115 @@ namespace rft {
                 // Start the actuator
                 _actuator->begin();
 
+                // Check the signal deadline independently of the loop, on
+                // boards that can
+                _board->startTimer(_watchdog.deadline() / 4,
+                                   watchdogTimer, this);
+
+                _stage = STARTING;
+                _beginTime = _board->getTime();
+
+                _scheduler.begin(_board);
+
             } // begin
 
             void update(State * state)
             {
-                // Grab control signal if available
+                // The stack depth from here on is what the firmware uses
+                _footprint.markStack();
+
+                selectRings();
+
+                if (_stage == STARTING) {
+                    checkStartup();
+                }
+
+                // Grab control signal if available; arming waits for the
+                // startup, but the switch history starts now
                 checkOpenLoopController(state);
 
-                // Update PID controllers task
-                _closedLoopTask.update(_board, _olc, _actuator, state);
+                // PID controllers, sensors and any other tasks, most urgent
+                // first
+                _state = state;
+                _scheduler.run(_board);
+            }
 
-                // Check sensors
-                checkSensors(state);
+            // Longest time the open-loop controller may go without new data
+            // while armed; call before begin()
+            void setSignalDeadline(float seconds)
+            {
+                _watchdog._deadline = seconds;
             }
 
         public:
 
+            // True once the board, sensors and actuator have all reported
+            // ready; the vehicle can't arm before
+            bool ready(void)
+            {
+                return _stage == RUNNING;
+            }
+
+            // Seconds from begin() to ready
+            float startupSeconds(void)
+            {
+                return _readyTime - _beginTime;
+            }
+
+            const Watchdog & watchdog(void) const
+            {
+                return _watchdog;
+            }
+
+            // Adds a periodic task alongside the built-in ones; see
+            // RFT_scheduler.hpp.  Returns its id, or -1 if there's no room.
+            int8_t addTask(Scheduler::task_t run, void * context,
+                           float period, uint8_t priority, uint8_t index=0)
+            {
+                return _scheduler.add(run, context, index, period, priority);
+            }
+
+            // For its latency and deadline statistics
+            Scheduler & scheduler(void)
+            {
+                return _scheduler;
+            }
+
+            // For objects outside the framework to register their RAM use
+            Footprint & footprint(void)
+            {
+                return _footprint;
+            }
+
             void addSensor(Sensor * sensor) 
             {
+                // Sensors are polled on every pass, once there are any
+                if (_sensor_count == 0) {
+                    _scheduler.add(sensorTask, this, 0, 0, Scheduler::SENSORS);
+                }
+
                 _sensors[_sensor_count++] = sensor;
             }
 
-            void addClosedLoopController(ClosedLoopController * controller,
+            // Call before begin(), after adding all the parameters
+            void setParameters(ParameterStore * parameters)
+            {
+                _parameters = parameters;
+            }
+
+            // Returns false if there's no room or the mode index is too
+            // high, and then begin() reports it and the firmware never
+            // starts; see RFT_closedlooptask.hpp
+            bool addClosedLoopController(ClosedLoopController * controller,
                                          uint8_t modeIndex=0) 
             {
-                _closedLoopTask.addController(controller, modeIndex);
+                if (!_closedLoopTask.addController(controller, modeIndex)) {
+                    _setupError = "Too many closed-loop controllers, "
+                        "or mode index too high";
+                    return false;
+                }
+
+                return true;
             }
 
     }; // class RFTPure
@@ -0,0 +1,263 @@
+/*
+   Cooperative earliest-deadline-first scheduler for periodic tasks
+
+   Each task is a callback with a period and a priority.  A task is released
+   once per period and its deadline is the end of that period.  On each pass
+   of the main loop, run() keeps picking the most urgent released task until
+   none is left: the highest priority first, and the earliest deadline among
+   tasks of equal priority.  It picks again after every task, so a control
+   task released partway through a pass runs next, ahead of whatever lower-
+   priority work was waiting.
+
+   Nothing is preempted: a task that has more work than it should do at once
+   keeps its own place in it and returns false, yielding.  It is resumed on a
+   later pass, still due by its original deadline, after anything more urgent
+   has run.  A task that returns true is done until its next release.
+
+       static bool logTask(void * context, uint8_t index)
+       {
+           // A few records, then yield if there are more
+           return ((Logger *)context)->writeSome();
+       }
+
+       scheduler.add(logTask, &logger, 0, 0.01, Scheduler::BACKGROUND);
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "RFT_board.hpp"
+#include "RFT_footprint.hpp"
+
+#ifndef RFT_SCHEDULER_MAX
+#define RFT_SCHEDULER_MAX 16
+#endif
+
+namespace rft {
+
+    class Scheduler {
+
+        public:
+
+            static const uint8_t MAX = RFT_SCHEDULER_MAX;
+
+            // Suggested priorities; any uint8_t will do, higher first
+            enum {
+                BACKGROUND = 0,
+                COMMS      = 1,
+                SENSORS    = 2,
+                CONTROL    = 3
+            };
+
+            // Returns true when the work for this release is done, false to
+            // yield and be resumed later; index is the one given to add()
+            typedef bool (*task_t)(void * context, uint8_t index);
+
+        private:
+
+            typedef struct {
+
+                task_t run;
+                void * context;
+                uint8_t index;
+                uint8_t priority;
+
+                float period;
+
+                // Start of the current period; the deadline is its end
+                float release;
+
+                // Yielded with work left for this release
+                bool pending;
+
+                uint32_t pass;
+
+                // Statistics
+                float worstLatency;
+                uint32_t misses;
+
+            } entry_t;
+
+            entry_t _tasks[MAX] = {};
+            uint8_t _count = 0;
+
+            uint32_t _pass = 0;
+
+            // Earliest time any task is due, so that most passes of a fast
+            // main loop end after one look at the clock
+            float _next = 0;
+
+            // Time at the start of the last pass
+            float _now = 0;
+
+            // The most urgent task that is due and hasn't run on this
+            // pass, or -1
+            int8_t pick(float time)
+            {
+                int8_t best = -1;
+
+                for (uint8_t k=0; k<_count; ++k) {
+
+                    entry_t & t = _tasks[k];
+
+                    if (t.pass == _pass || (!t.pending && time < t.release)) {
+                        continue;
+                    }
+
+                    if (best < 0) {
+                        best = k;
+                        continue;
+                    }
+
+                    entry_t & b = _tasks[best];
+
+                    if (t.priority > b.priority ||
+                            (t.priority == b.priority &&
+                             t.release + t.period < b.release + b.period)) {
+                        best = k;
+                    }
+                }
+
+                return best;
+            }
+
+            // Returns the time after the task, which is also the time the
+            // next pick sees, so the clock is read once per task
+            float execute(Board * board, entry_t & t, float start)
+            {
+                // How late the release started; resumptions don't count
+                if (!t.pending) {
+                    float latency = start - t.release;
+                    t.worstLatency = latency > t.worstLatency ?
+                        latency : t.worstLatency;
+                }
+
+                t.pass = _pass;
+
+                bool done = t.run(t.context, t.index);
+
+                float end = board->getTime();
+
+                if (!done) {
+                    t.pending = true;
+                    return end;
+                }
+
+                float deadline = t.release + t.period;
+
+                if (end > deadline && t.period > 0) {
+                    t.misses++;
+                }
+
+                t.pending = false;
+
+                // After falling more than a period behind, start afresh
+                // rather than running a burst of releases to catch up
+                t.release = end > deadline + t.period ? end : deadline;
+
+                return end;
+            }
+
+        public:
+
+            // period in seconds, zero for every pass; returns the task's
+            // id, or -1 if the scheduler is full
+            int8_t add(task_t run, void * context, uint8_t index,
+                    float period, uint8_t priority)
+            {
+                if (_count == MAX) {
+                    return -1;
+                }
+
+                entry_t & t = _tasks[_count];
+
+                t.run = run;
+                t.context = context;
+                t.index = index;
+                t.period = period;
+                t.priority = priority;
+
+                // Due on the next pass, if added after begin()
+                t.release = _now;
+                _next = _now;
+
+                return _count++;
+            }
+
+            // Releases every task now
+            void begin(Board * board)
+            {
+                float time = board->getTime();
+
+                for (uint8_t k=0; k<_count; ++k) {
+                    _tasks[k].release = time;
+                    _tasks[k].pending = false;
+                }
+
+                _now = time;
+                _next = time;
+            }
+
+            // One pass: runs each due task at most once, most urgent first
+            void run(Board * board)
+            {
+                float time = board->getTime();
+
+                if (time < _next) {
+                    return;
+                }
+
+                _now = time;
+
+                _pass++;
+
+                while (true) {
+
+                    int8_t k = pick(time);
+
+                    if (k < 0) {
+                        break;
+                    }
+
+                    time = execute(board, _tasks[k], time);
+                }
+
+                _next = time + 1e9f;
+
+                for (uint8_t k=0; k<_count; ++k) {
+                    float due = _tasks[k].pending ? 0 : _tasks[k].release;
+                    _next = due < _next ? due : _next;
+                }
+            }
+
+            uint8_t count(void)
+            {
+                return _count;
+            }
+
+            void addFootprint(Footprint & footprint)
+            {
+                footprint.add("Scheduler", sizeof(*this), MAX, &_count,
+                        sizeof(entry_t));
+            }
+
+            // Longest a release of the task has waited to start, in seconds
+            float worstLatency(uint8_t id)
+            {
+                return _tasks[id].worstLatency;
+            }
+
+            // Releases that finished after their deadline
+            uint32_t misses(uint8_t id)
+            {
+                return _tasks[id].misses;
+            }
+
+    }; // class Scheduler
+
+} // namespace rft
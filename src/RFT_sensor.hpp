@@ -22,6 +22,16 @@ namespace rft {
 
             virtual void begin(void) { }
 
+            // Polled after begin() until it returns true, and only then is
+            // modifyState() called; a sensor that must settle or calibrate
+            // does that here a little per call, rather than blocking in
+            // begin(), so it overlaps the other devices' startup
+            virtual bool ready(float time)
+            {
+                (void)time;
+                return true;
+            }
+
     };  // class Sensor
 
 } // namespace rft
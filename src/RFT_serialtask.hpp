@@ -10,8 +10,11 @@
 
 #include <RFT_timertask.hpp>
 #include <RFT_debugger.hpp>
+#include <RFT_logger.hpp>
 #include <RFT_actuator.hpp>
 #include <RFT_parser.hpp>
+#include <RFT_params.hpp>
+#include <RFT_telemetry.hpp>
 #include <rft_boards/realboard.hpp>
 
 namespace rft {
@@ -20,39 +23,304 @@ namespace rft {
 
         friend class RFT;
 
+        private:
+
+            // Set when a tick runs out of budget with work left
+            bool _backlog = false;
+
+            TelemetryScheduler * _telemetry = NULL;
+
+            ParameterStore * _parameters = NULL;
+
+            // Saving stalls on EEPROM or flash writes, so it waits for
+            // disarming
+            bool _armed = false;
+
+            uint32_t _deferredTicks = 0;
+            uint32_t _deferredBytes = 0;
+
+            bool sendLogRecords(void)
+            {
+                // Leave room for the MSP header and checksum
+                uint8_t buf[120];
+
+                uint8_t size = Logger::drain(buf, sizeof(buf));
+
+                if (size > 0) {
+
+                    prepareToSendBytes(Logger::MSP_ID, size);
+
+                    for (uint8_t k=0; k<size; ++k) {
+                        sendByte(buf[k]);
+                    }
+
+                    completeSend();
+                }
+
+                return size > 0;
+            }
+
+            // The firmware's, for FOOTPRINT_GET
+            Footprint * _footprint = NULL;
+
+            void addFootprint(Footprint & footprint)
+            {
+                _footprint = &footprint;
+
+                Parser::addFootprint(footprint, "SerialTask", sizeof(*this));
+            }
+
         protected:
 
             static constexpr float FREQ = 66;
 
             bool _useTelemetryPort = false;
 
+            // Set false in a subclass to leave the RFT_LOG records for
+            // another serial task or a LogStream
+            bool _sendLogRecords = true;
+
+            // Most Debugger bytes to pass along per tick
+            uint16_t _debugBudget = 64;
+
+            // Most bytes read plus written, and seconds spent, per tick;
+            // the time is checked every few bytes, to the resolution of
+            // Board::getTime()
+            uint16_t _byteBudget = 256;
+            float _timeBudget = 0.001;
+
             SerialTask(bool secondaryPort=false)
                 : TimerTask(FREQ)
             {
                 _useTelemetryPort = secondaryPort;
             }
 
-            void update(Board * board, Actuator * actuator, State * state)
+            // Sends the scheduler's streams on this task's port, after the
+            // replies to requests, which count against the same budget
+            void setTelemetry(TelemetryScheduler * telemetry)
+            {
+                _telemetry = telemetry;
+            }
+
+            // Answers the PARAM_* messages from this store
+            void setParameters(ParameterStore * parameters)
+            {
+                _parameters = parameters;
+            }
+
+            // For the PARAM_* handlers that msppg generates; the message
+            // types come from its messages.hpp
+
+            void describeParameter(int16_t & index, int16_t & count,
+                    uint8_t & type, int32_t & name, float & value,
+                    float & minimum, float & maximum)
             {
-                if (!TimerTask::ready(board)) {
+                count = _parameters ? _parameters->count() : 0;
+
+                if (index < 0 || index >= count) {
+                    index = -1;
+                    type = 0;
+                    name = 0;
+                    value = 0;
+                    minimum = 0;
+                    maximum = 0;
                     return;
                 }
 
+                type = _parameters->type(index);
+                name = (int32_t)_parameters->nameHash(index);
+                value = _parameters->getFloat(index);
+                minimum = _parameters->minimum(index);
+                maximum = _parameters->maximum(index);
+            }
+
+            void describeStore(int16_t & count, int32_t & layout,
+                    int32_t & checksum, uint8_t & ok)
+            {
+                count = _parameters ? _parameters->count() : 0;
+                layout = _parameters ? (int32_t)_parameters->layout() : 0;
+                checksum = _parameters ?
+                    (int32_t)_parameters->currentChecksum() : 0;
+                ok = _parameters != NULL;
+            }
+
+            template <typename M>
+            void sendParameter(int16_t index)
+            {
+                int16_t count = 0;
+                uint8_t type = 0;
+                int32_t name = 0;
+                float value = 0, minimum = 0, maximum = 0;
+
+                describeParameter(index, count, type, name, value, minimum,
+                        maximum);
+
+                sendMessage<M>(index, count, type, name, value, minimum,
+                        maximum);
+            }
+
+            // Replies with the value as clamped
+            template <typename M>
+            void setParameter(int16_t index, float value)
+            {
+                // Checked before narrowing, so that 256 isn't parameter 0
+                if (_parameters && index >= 0 && index < _parameters->count()) {
+                    _parameters->set(index, value);
+                }
+
+                sendParameter<M>(index);
+            }
+
+            // Stores the current values, or with reload set brings back the
+            // stored ones (the defaults, if there are none); replies with ok
+            // clear if that failed or the vehicle is armed
+            template <typename M>
+            void saveParameters(uint8_t reload)
+            {
+                bool ok = _parameters && !_armed &&
+                    (reload ? _parameters->load() : _parameters->save());
+
+                int16_t count = 0;
+                int32_t layout = 0, checksum = 0;
+                uint8_t present = 0;
+                describeStore(count, layout, checksum, present);
+
+                sendMessage<M>(count, layout, checksum, (uint8_t)ok);
+            }
+
+            // For the FOOTPRINT_GET handler that msppg generates.  Replies
+            // with a Footprint::MSP_ID message: the index (0xFF if out of
+            // range) and the number of entries as bytes; size, capacity and
+            // bytes used as 32-bit integers; then the name, unterminated.
+            void sendFootprint(int16_t index)
+            {
+                const char * name = "";
+                uint32_t size = 0, capacity = 0, used = 0;
+
+                bool valid = _footprint && index >= 0 && index < 256 &&
+                    _footprint->describe(index, name, size, capacity, used);
+
+                uint8_t length = 0;
+                while (valid && length < Footprint::NAME_SIZE &&
+                        name[length]) {
+                    length++;
+                }
+
+                prepareToSendBytes(Footprint::MSP_ID, 14 + length);
+
+                sendByte(valid ? index : 0xFF);
+                sendByte(_footprint ? _footprint->count() : 0);
+                sendInt(size);
+                sendInt(capacity);
+                sendInt(used);
+
+                for (uint8_t k=0; k<length; ++k) {
+                    sendByte(name[k]);
+                }
+
+                completeSend();
+            }
+
+            void update(Board * board, Actuator * actuator, State * state)
+            {
+                // Work left from the last tick doesn't wait for the timer
+                if (_backlog || TimerTask::ready(board)) {
+                    run(board, actuator, state);
+                }
+            }
+
+            // One tick, whenever a Scheduler releases or resumes it;
+            // returns false if it stopped at its budget with work left
+            bool run(Board * board, Actuator * actuator, State * state)
+            {
                 RealBoard * realboard = (RealBoard *)board;
 
-                while (realboard->serialAvailable(_useTelemetryPort) > 0) {
-                    Parser::parse(realboard->serialRead(_useTelemetryPort));
+                float time = realboard->getTime();
+                float deadline = time + _timeBudget;
+                uint16_t bytes = 0;
+                uint16_t written = 0;
+                bool logChecked = !_sendLogRecords;
+
+                _backlog = false;
+
+                _armed = state->armed;
+
+                while (true) {
+
+                    // Finish a reply before parsing the next request, whose
+                    // reply would overwrite it
+                    if (Parser::availableBytes() > 0) {
+                        realboard->serialWrite(Parser::readByte(),
+                                               _useTelemetryPort);
+                        written++;
+                    }
+
+                    else if (realboard->serialAvailable(_useTelemetryPort) > 0) {
+                        Parser::parse(realboard->serialRead(_useTelemetryPort));
+                    }
+
+                    else if (!logChecked) {
+                        logChecked = true;
+                        if (!sendLogRecords()) {
+                            break;
+                        }
+                        continue;
+                    }
+
+                    else {
+                        break;
+                    }
+
+                    bytes++;
+
+                    if (bytes >= _byteBudget ||
+                            ((bytes & 15) == 0 &&
+                             realboard->getTime() > deadline)) {
+
+                        uint16_t left = Parser::availableBytes() +
+                            realboard->serialAvailable(_useTelemetryPort);
+
+                        if (left > 0) {
+                            _backlog = true;
+                            _deferredTicks++;
+                            _deferredBytes += left;
+                        }
+
+                        break;
+                    }
                 }
 
-                while (Parser::availableBytes() > 0) {
-                    realboard->serialWrite(Parser::readByte(),
-                                           _useTelemetryPort);
+                realboard->serialFlush(_useTelemetryPort);
+
+                if (_telemetry) {
+                    _telemetry->charge(_useTelemetryPort, written);
+                    _telemetry->service(realboard, _useTelemetryPort, time);
                 }
 
+                // Send buffered debug output, as far as the port has room
+                uint16_t space = realboard->debugWriteSpace();
+                Debugger::drain(space < _debugBudget ? space : _debugBudget);
+
                 // Support motor testing from GCS
                 if (!state->armed) {
                     actuator->runDisarmed();
                 }
+
+                return !_backlog;
+            }
+
+        public:
+
+            // Ticks that ended with serial work left for the next one
+            uint32_t deferredTicks(void)
+            {
+                return _deferredTicks;
+            }
+
+            // Bytes left over, summed across those ticks
+            uint32_t deferredBytes(void)
+            {
+                return _deferredBytes;
             }
 
     };  // SerialTask
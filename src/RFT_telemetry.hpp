@@ -0,0 +1,379 @@
+/*
+   Priority scheduling of outgoing telemetry across serial ports
+
+   A TelemetryStream sends one kind of unsolicited MSP message (vehicle state,
+   RFT_LOG records, ...) at up to a given rate, with a priority.  The
+   TelemetryScheduler keeps a byte budget for each port, refilled from an
+   estimate of the link's bandwidth, and on each SerialTask tick sends the due
+   frames in priority order for as long as they fit.
+
+   A due stream gains a point of priority for every tick it waits, and goes
+   ahead of everything once it is overdue by more than the scheduler's
+   maximum delay.  A frame that doesn't fit holds back everything below it
+   until the budget has grown, so a low-priority stream on a saturated link
+   still gets a frame out at least that often.
+
+   RFT_LOG() records form a single queue, so a LogStream on several ports
+   sends each record on whichever port gets to it first.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "RFT_logger.hpp"
+#include "rft_boards/realboard.hpp"
+
+namespace rft {
+
+    // Builds one outgoing MSP message
+    class TelemetryFrame {
+
+        friend class TelemetryScheduler;
+
+        public:
+
+            // Header, type and checksum take the rest of a Parser buffer
+            static const uint8_t MAX_PAYLOAD = 122;
+
+            static const uint8_t OVERHEAD = 6;
+
+        private:
+
+            uint8_t _buf[MAX_PAYLOAD + OVERHEAD] = {};
+            uint8_t _size = 0;
+            uint8_t _checksum = 0;
+
+            void add(uint8_t c)
+            {
+                _buf[_size++] = c;
+                _checksum ^= c;
+            }
+
+        public:
+
+            void begin(uint8_t type)
+            {
+                _buf[0] = '$';
+                _buf[1] = 'M';
+                _buf[2] = '>';
+                _size = 3;
+                _checksum = 0;
+                add(0); // payload size, filled in by end()
+                add(type);
+            }
+
+            void addByte(uint8_t value)
+            {
+                add(value);
+            }
+
+            void addShort(int16_t value)
+            {
+                add(value);
+                add(value >> 8);
+            }
+
+            void addInt(int32_t value)
+            {
+                for (uint8_t k=0; k<4; ++k) {
+                    add(value >> (8*k));
+                }
+            }
+
+            void addFloat(float value)
+            {
+                uint32_t bits = 0;
+                memcpy(&bits, &value, 4);
+                addInt(bits);
+            }
+
+            void end(void)
+            {
+                uint8_t payload = _size - 5;
+                _buf[3] = payload;
+                _checksum ^= payload;
+                _buf[_size++] = _checksum;
+            }
+
+            uint8_t size(void)
+            {
+                return _size;
+            }
+
+    }; // class TelemetryFrame
+
+    class TelemetryStream {
+
+        friend class TelemetryScheduler;
+
+        public:
+
+            static const uint8_t PRIMARY = 0x01;
+            static const uint8_t TELEMETRY = 0x02;
+
+        private:
+
+            uint8_t _priority = 0;
+            float _period = 0;
+            uint8_t _ports = PRIMARY;
+
+            // Kept on a fixed grid, so that the rate holds on average when
+            // it doesn't divide the tick rate
+            float _nextDue[2] = {};
+            uint8_t _waiting[2] = {};
+
+            uint32_t _frames[2] = {};
+
+        protected:
+
+            // rate: most frames per second on each port; ports: mask of
+            // PRIMARY and TELEMETRY
+            TelemetryStream(uint8_t priority, float rate, uint8_t ports=PRIMARY)
+            {
+                _priority = priority;
+                _period = rate > 0 ? 1 / rate : 0;
+                _ports = ports;
+            }
+
+            // Largest frame the next fill() could produce, in bytes
+            virtual uint8_t frameSize(void)
+            {
+                return TelemetryFrame::MAX_PAYLOAD + TelemetryFrame::OVERHEAD;
+            }
+
+            // Writes a frame of at most maxPayload bytes of payload; returns
+            // false if there is nothing to send
+            virtual bool fill(TelemetryFrame & frame, uint8_t maxPayload) = 0;
+
+        public:
+
+            uint32_t framesSent(bool telemetryPort)
+            {
+                return _frames[telemetryPort];
+            }
+
+    }; // class TelemetryStream
+
+    // Sends the RFT_LOG() records, in place of SerialTask's own draining
+    class LogStream : public TelemetryStream {
+
+        protected:
+
+            uint8_t frameSize(void) override
+            {
+                uint16_t pending = Logger::pending();
+
+                return TelemetryFrame::OVERHEAD +
+                    (pending < TelemetryFrame::MAX_PAYLOAD ?
+                     pending : TelemetryFrame::MAX_PAYLOAD);
+            }
+
+            bool fill(TelemetryFrame & frame, uint8_t maxPayload) override
+            {
+                uint8_t buf[TelemetryFrame::MAX_PAYLOAD];
+
+                uint8_t size = Logger::drain(buf, maxPayload);
+
+                if (size == 0) {
+                    return false;
+                }
+
+                frame.begin(Logger::MSP_ID);
+                for (uint8_t k=0; k<size; ++k) {
+                    frame.addByte(buf[k]);
+                }
+                frame.end();
+
+                return true;
+            }
+
+        public:
+
+            LogStream(uint8_t priority=0, float rate=20,
+                      uint8_t ports=PRIMARY)
+                : TelemetryStream(priority, rate, ports)
+            {
+            }
+
+    }; // class LogStream
+
+    class TelemetryScheduler {
+
+        friend class SerialTask;
+
+        private:
+
+            static const uint8_t MAX_STREAMS = 16;
+
+            TelemetryStream * _streams[MAX_STREAMS] = {};
+            uint8_t _streamCount = 0;
+
+            // Per port: estimated bytes per second, budget in bytes and the
+            // time it was last refilled
+            float _bandwidth[2] = {};
+            float _budget[2] = {};
+            float _time[2] = {};
+
+            uint32_t _bytes[2] = {};
+
+            float _maxDelay = 1;
+
+            // Whatever SerialTask wrote in reply to requests
+            void charge(bool telemetryPort, uint16_t bytes)
+            {
+                _budget[telemetryPort] -= bytes;
+            }
+
+            static float burst(float bandwidth)
+            {
+                // At least a full frame, else at most 50 ms of traffic
+                float max = TelemetryFrame::MAX_PAYLOAD + TelemetryFrame::OVERHEAD;
+                return bandwidth * 0.05f > max ? bandwidth * 0.05f : max;
+            }
+
+            bool due(TelemetryStream * s, uint8_t port, float time)
+            {
+                return (s->_ports & (1 << port)) &&
+                    time >= s->_nextDue[port];
+            }
+
+            void service(RealBoard * board, bool telemetryPort, float time)
+            {
+                uint8_t port = telemetryPort;
+
+                if (_bandwidth[port] <= 0) {
+                    return;
+                }
+
+                float dt = time - _time[port];
+                _time[port] = time;
+
+                float max = burst(_bandwidth[port]);
+                _budget[port] += dt * _bandwidth[port];
+                _budget[port] = _budget[port] > max ? max : _budget[port];
+
+                // Streams sent, or found with nothing to send, this tick
+                bool done[MAX_STREAMS] = {};
+
+                while (true) {
+
+                    // Highest priority, counting time waited, of those due
+                    int16_t best = -1;
+                    uint16_t bestScore = 0;
+
+                    for (uint8_t k=0; k<_streamCount; ++k) {
+
+                        TelemetryStream * s = _streams[k];
+
+                        if (done[k] || !due(s, port, time)) {
+                            continue;
+                        }
+
+                        uint16_t score = s->_priority + s->_waiting[port];
+
+                        if (time - s->_nextDue[port] > _maxDelay) {
+                            score += 512;
+                        }
+
+                        if (best < 0 || score > bestScore) {
+                            best = k;
+                            bestScore = score;
+                        }
+                    }
+
+                    if (best < 0) {
+                        break;
+                    }
+
+                    TelemetryStream * s = _streams[best];
+
+                    // Hold the budget for this frame rather than letting a
+                    // lower priority one take it
+                    if (s->frameSize() > _budget[port]) {
+                        break;
+                    }
+
+                    done[best] = true;
+
+                    float room = _budget[port] - TelemetryFrame::OVERHEAD;
+
+                    TelemetryFrame frame;
+
+                    if (room < 0 || !s->fill(frame,
+                                room < TelemetryFrame::MAX_PAYLOAD ?
+                                (uint8_t)room : TelemetryFrame::MAX_PAYLOAD)) {
+                        s->_waiting[port] = 0;
+                        continue;
+                    }
+
+                    for (uint8_t k=0; k<frame._size; ++k) {
+                        board->serialWrite(frame._buf[k], telemetryPort);
+                    }
+
+                    _budget[port] -= frame._size;
+                    _bytes[port] += frame._size;
+
+                    // Don't make up for lost time in a burst
+                    s->_nextDue[port] += s->_period;
+                    if (s->_nextDue[port] < time - s->_period) {
+                        s->_nextDue[port] = time;
+                    }
+                    s->_waiting[port] = 0;
+                    s->_frames[port]++;
+                }
+
+                // Anything still due has waited another tick
+                for (uint8_t k=0; k<_streamCount; ++k) {
+
+                    TelemetryStream * s = _streams[k];
+
+                    if (!done[k] && due(s, port, time) &&
+                            s->_waiting[port] < 255) {
+                        s->_waiting[port]++;
+                    }
+                }
+
+                board->serialFlush(telemetryPort);
+            }
+
+        public:
+
+            // Returns false if the scheduler is full
+            bool addStream(TelemetryStream * stream)
+            {
+                if (_streamCount == MAX_STREAMS) {
+                    return false;
+                }
+
+                _streams[_streamCount++] = stream;
+
+                return true;
+            }
+
+            // Estimated link capacity in bytes per second, e.g. baud / 10 for
+            // 8N1; a port with no bandwidth gets no telemetry
+            void setBandwidth(bool telemetryPort, float bytesPerSecond)
+            {
+                _bandwidth[telemetryPort] = bytesPerSecond;
+            }
+
+            // Longest a due stream waits behind higher-priority ones
+            void setMaxDelay(float seconds)
+            {
+                _maxDelay = seconds;
+            }
+
+            uint32_t bytesSent(bool telemetryPort)
+            {
+                return _bytes[telemetryPort];
+            }
+
+    }; // class TelemetryScheduler
+
+} // namespace rft
@@ -42,6 +42,11 @@ namespace rft {
                 return false;
              }
 
+            float period(void)
+            {
+                return _period;
+            }
+
     };  // TimerTask
 
 } // namespace rft
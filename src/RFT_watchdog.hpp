@@ -0,0 +1,101 @@
+/*
+   Watchdog cutting the motors when the open-loop controller goes quiet
+
+   RFTPure feeds the watchdog whenever the open-loop controller has new data,
+   and cuts the motors once the time since then passes the deadline, whether
+   or not the controller's lostSignal() has noticed.  On boards that provide
+   Board::startTimer(), the check also runs from a timer, so that a stalled
+   main loop cannot hold off the cut: ESP32 (TinyPico) and Teensy boards, and
+   SimBoard.  Elsewhere, e.g. on the STM32L4, the check runs only from the
+   main loop.
+
+   Every cut for signal loss records its latency, the time from the last good
+   update to Actuator::cut(), in a histogram spanning twice the deadline.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace rft {
+
+    class Watchdog {
+
+        friend class RFTPure;
+
+        public:
+
+            static const uint8_t BINS = 16;
+
+        private:
+
+            float _deadline = 0.1;
+
+            // Written by the main loop and read by the timer callback.  On
+            // eight-bit boards a read may tear; use a 32-bit board if the
+            // timer is in use.
+            volatile float _lastGood = 0;
+
+            uint32_t _histogram[BINS] = {};
+            uint32_t _count = 0;
+            float _worst = 0;
+
+            void feed(float time)
+            {
+                _lastGood = time;
+            }
+
+            bool expired(float time)
+            {
+                return time - _lastGood > _deadline;
+            }
+
+            void record(float time)
+            {
+                float latency = time - _lastGood;
+
+                int32_t bin = (int32_t)(latency / binWidth());
+                _histogram[bin < 0 ? 0 : bin >= BINS ? BINS-1 : bin]++;
+
+                _worst = latency > _worst ? latency : _worst;
+                _count++;
+            }
+
+        public:
+
+            float deadline(void) const
+            {
+                return _deadline;
+            }
+
+            float binWidth(void) const
+            {
+                return 2 * _deadline / BINS;
+            }
+
+            // Cuts in [bin*binWidth(), (bin+1)*binWidth()); the last bin
+            // also holds everything later
+            uint32_t histogram(uint8_t bin) const
+            {
+                return _histogram[bin];
+            }
+
+            // Cuts for signal loss so far
+            uint32_t count(void) const
+            {
+                return _count;
+            }
+
+            // Longest latency so far, in seconds
+            float worst(void) const
+            {
+                return _worst;
+            }
+
+    }; // class Watchdog
+
+} // namespace rft
@@ -17,33 +17,43 @@ namespace rft {
     class RealBoard : public Board {
 
         friend class SerialTask;
+        friend class TelemetryScheduler;
 
         private:
 
-            static constexpr float   LED_STARTUP_FLASH_SECONDS = 1.0;
-            static constexpr uint8_t LED_STARTUP_FLASH_COUNT   = 20;
-            static constexpr float   LED_SLOWFLASH_SECONDS     = 0.25;
+            // Fast flash while starting up, slow flash for controllers that
+            // ask for it; both are half-periods, timed from the main loop
+            static constexpr float LED_STARTUP_FLASH_SECONDS = 0.025;
+            static constexpr float LED_SLOWFLASH_SECONDS     = 0.25;
 
             bool _shouldFlash = false;
 
+            // Flash timing
+            float _flashTime = 0;
+            bool _flashState = false;
+
+            void toggleLed(float seconds)
+            {
+                float time = getTime();
+
+                if (time-_flashTime > seconds) {
+                    _flashState = !_flashState;
+                    setLed(_flashState);
+                    _flashTime = time;
+                }
+            }
+
         protected:
 
             static const uint32_t SERIAL_BAUD = 115200;
 
+            // Returns at once; RFTPure flashes the LED through
+            // showStartingStatus() until everything has started
             void begin(void)
             {
-                // Flash LED
-                float pauseSeconds = LED_STARTUP_FLASH_SECONDS /
-                                     LED_STARTUP_FLASH_COUNT;
-                setLed(false);
-                for (uint8_t i = 0; i < LED_STARTUP_FLASH_COUNT; i++) {
-                    setLed(true);
-                    delaySeconds(pauseSeconds);
-                    setLed(false);
-                    delaySeconds(pauseSeconds);
-                }
                 setLed(false);
 
+                _flashState = false;
                 _shouldFlash = false;
             }
 
@@ -65,29 +75,27 @@ namespace rft {
                 }
             }
 
+            void showStartingStatus(void)
+            {
+                toggleLed(LED_STARTUP_FLASH_SECONDS);
+            }
+
             void flashLed(bool shouldflash)
             {
                 if (shouldflash) {
-
-                    static float _time;
-                    static bool state;
-
-                    float time = getTime();
-
-                    if (time-_time > LED_SLOWFLASH_SECONDS) {
-                        state = !state;
-                        setLed(state);
-                        _time = time;
-                    }
+                    toggleLed(LED_SLOWFLASH_SECONDS);
                 }
 
                 _shouldFlash = shouldflash;
             }
 
-            void error(const char * errmsg) 
+            // Halts, since the vehicle cannot fly; nothing else is running,
+            // so this is the one place that drains debug output unmetered
+            void error(const char * errmsg) override
             {
                 while (true) {
                     Debugger::printf("%s\n", errmsg);
+                    Debugger::drain();
                     delaySeconds(0.1);
                 }
             }
@@ -100,6 +108,18 @@ namespace rft {
 
             virtual void serialWrite(uint8_t c, bool secondaryPort) = 0;
 
+            // For boards that buffer writes
+            virtual void serialFlush(bool secondaryPort)
+            {
+                (void)secondaryPort;
+            }
+
+            // Bytes Debugger::outbuf() can take without blocking
+            virtual uint16_t debugWriteSpace(void)
+            {
+                return RFT_DEBUG_BUFSIZE;
+            }
+
     }; // class RealBoard
 
 } // namespace rft
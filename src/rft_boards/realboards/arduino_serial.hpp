@@ -4,6 +4,21 @@
    Support communication over Serial (USB) and
    telemetry port. 
 
+   The ParameterStore image is kept at the start of the EEPROM; on the
+   ESP32, whose EEPROM library caches a flash sector in RAM, loading it is a
+   memcpy from that cache.  That is on the cores known to ship an EEPROM
+   library (AVR, Teensy, STM32, ESP32); elsewhere, e.g. SAMD and nRF52,
+   parameters aren't stored unless you define RFT_HAVE_EEPROM for an
+   AVR-style EEPROM library you provide.
+
+   The watchdog's timer (Board::startTimer()) is an esp_timer on the ESP32
+   and an IntervalTimer on the Teensy; other cores don't have one.
+
+   Debug output goes out only as fast as Serial.availableForWrite() says
+   there is room.  On a core whose Serial doesn't implement that (it always
+   says 0), define RFT_NO_AVAILABLE_FOR_WRITE to send a few bytes a tick
+   instead, which may then block briefly on a full port.
+
    Copyright (c) 2021 Simon D. Levy
 
    MIT License
@@ -11,6 +26,24 @@
 
 #pragma once
 
+#ifndef RFT_HAVE_EEPROM
+#if defined(ARDUINO_ARCH_AVR) || defined(TEENSYDUINO) || \
+    defined(ARDUINO_ARCH_STM32) || defined(ARDUINO_ARCH_STM32L4) || \
+    defined(ESP32)
+#define RFT_HAVE_EEPROM
+#endif
+#endif
+
+#ifdef RFT_HAVE_EEPROM
+#include <EEPROM.h>
+#endif
+
+#if defined(ESP32)
+#include <esp_timer.h>
+#elif defined(TEENSYDUINO)
+#include <IntervalTimer.h>
+#endif
+
 #include "rft_boards/realboard.hpp"
 
 namespace rft {
@@ -21,6 +54,41 @@ namespace rft {
 
             HardwareSerial * _telemetryPort = NULL;
 
+#if defined(RFT_HAVE_EEPROM) && defined(ESP32)
+            static const uint16_t EEPROM_SIZE = 1024;
+#endif
+
+#if defined(ESP32)
+            esp_timer_handle_t _timer = NULL;
+#elif defined(TEENSYDUINO)
+            IntervalTimer _timer;
+
+            // IntervalTimer calls a function without arguments, so the
+            // callback and its context are kept where it can find them
+            struct TimerTarget {
+                void (*callback)(void *);
+                void * context;
+            };
+
+            static TimerTarget & timerTarget(void)
+            {
+                static TimerTarget target;
+                return target;
+            }
+
+            static void timerInterrupt(void)
+            {
+                TimerTarget & target = timerTarget();
+                target.callback(target.context);
+            }
+#endif
+
+#ifdef RFT_NO_AVAILABLE_FOR_WRITE
+            // Debug bytes per tick where the core can't say how much room
+            // there is; small enough to go into any hardware FIFO
+            static const uint16_t DEBUG_WRITE_FALLBACK = 16;
+#endif
+
         protected:
 
             ArduinoSerial(HardwareSerial * telemetryPort=NULL)
@@ -59,6 +127,94 @@ namespace rft {
                 }
             }
 
+            uint16_t debugWriteSpace(void)
+            {
+#ifdef RFT_NO_AVAILABLE_FOR_WRITE
+                return DEBUG_WRITE_FALLBACK;
+#else
+                int space = Serial.availableForWrite();
+
+                return space > 0 ? space : 0;
+#endif
+            }
+
+#if defined(ESP32)
+
+            // Runs from the esp_timer task, which preempts the loop
+            bool startTimer(float period,
+                            void (*callback)(void *),
+                            void * context) override
+            {
+                esp_timer_create_args_t args = {};
+                args.callback = callback;
+                args.arg = context;
+                args.name = "rft";
+
+                return esp_timer_create(&args, &_timer) == ESP_OK &&
+                    esp_timer_start_periodic(_timer,
+                            (uint64_t)(period * 1e6f)) == ESP_OK;
+            }
+
+#elif defined(TEENSYDUINO)
+
+            // Runs from the timer interrupt; there is one timer target, as
+            // there is one firmware
+            bool startTimer(float period,
+                            void (*callback)(void *),
+                            void * context) override
+            {
+                timerTarget().callback = callback;
+                timerTarget().context = context;
+
+                return _timer.begin(timerInterrupt, period * 1e6f);
+            }
+
+#endif
+
+#ifdef RFT_HAVE_EEPROM
+
+            bool storageRead(void * dst, uint16_t size) override
+            {
+#ifdef ESP32
+                if (!EEPROM.begin(EEPROM_SIZE) || size > EEPROM_SIZE) {
+                    return false;
+                }
+                memcpy(dst, EEPROM.getDataPtr(), size);
+#else
+                if (size > EEPROM.length()) {
+                    return false;
+                }
+                uint8_t * bytes = (uint8_t *)dst;
+                for (uint16_t k=0; k<size; ++k) {
+                    bytes[k] = EEPROM.read(k);
+                }
+#endif
+                return true;
+            }
+
+            bool storageWrite(const void * src, uint16_t size) override
+            {
+#ifdef ESP32
+                if (!EEPROM.begin(EEPROM_SIZE) || size > EEPROM_SIZE) {
+                    return false;
+                }
+                memcpy(EEPROM.getDataPtr(), src, size);
+                return EEPROM.commit();
+#else
+                if (size > EEPROM.length()) {
+                    return false;
+                }
+                // Only changed bytes are written, sparing the cells
+                const uint8_t * bytes = (const uint8_t *)src;
+                for (uint16_t k=0; k<size; ++k) {
+                    EEPROM.update(k, bytes[k]);
+                }
+                return true;
+#endif
+            }
+
+#endif // RFT_HAVE_EEPROM
+
             void begin(void)
             {
                 // Start serial communcation for GCS/debugging
@@ -69,7 +225,7 @@ namespace rft {
                     _telemetryPort->begin(SERIAL_BAUD);
                 }
 
-                // This will blink the LED
+                // Turns the LED off, ready for the startup flashing
                 RealBoard::begin();
             }
 
@@ -0,0 +1,414 @@
+/*
+   Class for serial comms on Linux hosts, for software-in-the-loop builds
+
+   The primary port is a pseudo-terminal, so anything that opens a serial
+   device (pyserial in stateviz.py, the Java parser, a GCS) can attach to its
+   slave side exactly as it would to a USB serial port.  The telemetry port,
+   if given a path, is a Unix domain socket that accepts one client at a time.
+
+   Both are non-blocking.  Reads fill a buffer with one read() call and
+   writes are collected until serialFlush(), so the syscall count scales with
+   SerialTask ticks rather than with bytes.
+
+   Given a storage path, the board keeps the ParameterStore image in that
+   file, memory-mapped, so loading it is a memcpy from the mapping.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// RealBoard expects the Arduino timing functions
+#ifndef ARDUINO
+
+static inline uint32_t micros(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+static inline void delay(uint32_t msec)
+{
+    usleep(msec * 1000);
+}
+
+#endif
+
+#include "rft_boards/realboard.hpp"
+
+namespace rft {
+
+    class LinuxPort {
+
+        private:
+
+            static const uint16_t BUFSIZE = 4096;
+
+            int _fd = -1;
+            int _listenFd = -1;
+
+            // Slave side of the pseudo-terminal
+            char _ptyName[64] = {};
+
+            uint8_t _rx[BUFSIZE] = {};
+            uint16_t _rxHead = 0;
+            uint16_t _rxTail = 0;
+
+            uint8_t _tx[BUFSIZE] = {};
+            uint16_t _txSize = 0;
+
+            void acceptClient(void)
+            {
+                if (_fd < 0 && _listenFd >= 0) {
+                    _fd = accept4(_listenFd, NULL, NULL, SOCK_NONBLOCK);
+                }
+            }
+
+            void dropClient(void)
+            {
+                // A pseudo-terminal stays open for the next client
+                if (_listenFd >= 0 && _fd >= 0) {
+                    close(_fd);
+                    _fd = -1;
+                }
+                _txSize = 0;
+            }
+
+        public:
+
+            // Bytes discarded because the peer was absent or not keeping up
+            uint32_t dropped = 0;
+
+            ~LinuxPort(void)
+            {
+                if (_fd >= 0) {
+                    close(_fd);
+                }
+                if (_listenFd >= 0) {
+                    close(_listenFd);
+                }
+            }
+
+            // Opens a pseudo-terminal, optionally symlinking its slave side
+            // to a fixed path; returns the slave's name, or NULL on failure,
+            // leaving the port closed
+            const char * openPty(const char * link=NULL)
+            {
+                _fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+                if (_fd < 0) {
+                    return NULL;
+                }
+
+                // ptsname() shares one buffer among all the ports
+                bool ok = grantpt(_fd) == 0 && unlockpt(_fd) == 0 &&
+                    ptsname_r(_fd, _ptyName, sizeof(_ptyName)) == 0;
+
+                if (ok && link) {
+                    unlink(link);
+                    ok = symlink(_ptyName, link) == 0;
+                }
+
+                if (!ok) {
+                    close(_fd);
+                    _fd = -1;
+                    return NULL;
+                }
+
+                struct termios tio;
+                tcgetattr(_fd, &tio);
+                cfmakeraw(&tio);
+                tcsetattr(_fd, TCSANOW, &tio);
+
+                return _ptyName;
+            }
+
+            bool listenUnix(const char * path)
+            {
+                struct sockaddr_un addr;
+                memset(&addr, 0, sizeof(addr));
+                addr.sun_family = AF_UNIX;
+                strncpy(addr.sun_path, path, sizeof(addr.sun_path)-1);
+
+                unlink(path);
+
+                _listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+                return _listenFd >= 0 &&
+                    bind(_listenFd, (struct sockaddr *)&addr,
+                         sizeof(addr)) == 0 &&
+                    listen(_listenFd, 1) == 0;
+            }
+
+            uint8_t available(void)
+            {
+                if (_rxHead == _rxTail) {
+
+                    acceptClient();
+
+                    _rxHead = 0;
+                    _rxTail = 0;
+
+                    if (_fd >= 0) {
+
+                        ssize_t n = ::read(_fd, _rx, BUFSIZE);
+
+                        if (n > 0) {
+                            _rxTail = n;
+                        }
+
+                        // Socket client hung up
+                        else if (n == 0) {
+                            dropClient();
+                        }
+                    }
+                }
+
+                uint16_t n = _rxTail - _rxHead;
+                return n > 255 ? 255 : n;
+            }
+
+            uint8_t read(void)
+            {
+                return _rxHead < _rxTail ? _rx[_rxHead++] : 0;
+            }
+
+            void write(uint8_t c)
+            {
+                if (_txSize == BUFSIZE) {
+                    flush();
+                }
+
+                if (_txSize < BUFSIZE) {
+                    _tx[_txSize++] = c;
+                }
+
+                else {
+                    dropped++;
+                }
+            }
+
+            void flush(void)
+            {
+                acceptClient();
+
+                uint16_t sent = 0;
+
+                while (_fd >= 0 && sent < _txSize) {
+
+                    // Sockets would raise SIGPIPE on a vanished client
+                    ssize_t n = _listenFd >= 0 ?
+                        send(_fd, _tx + sent, _txSize - sent, MSG_NOSIGNAL) :
+                        ::write(_fd, _tx + sent, _txSize - sent);
+
+                    if (n > 0) {
+                        sent += n;
+                    }
+
+                    // Peer not reading (EAGAIN) or not attached (EIO): drop
+                    // the rest rather than stall the loop
+                    else {
+                        if (n < 0 && errno == EPIPE) {
+                            dropClient();
+                        }
+                        break;
+                    }
+                }
+
+                dropped += _txSize - sent;
+                _txSize = 0;
+            }
+
+    }; // class LinuxPort
+
+    class LinuxStorage {
+
+        private:
+
+            uint8_t * _map = NULL;
+
+        public:
+
+            // One page, far more than RFT_PARAM_MAX parameters need
+            static const uint16_t SIZE = 4096;
+
+            // Creates the file, zero-filled, if needed; returns false if it
+            // can't be opened and mapped
+            bool open(const char * path)
+            {
+                int fd = ::open(path, O_RDWR | O_CREAT, 0644);
+
+                if (fd < 0) {
+                    return false;
+                }
+
+                struct stat st = {};
+                if (fstat(fd, &st) < 0 ||
+                        (st.st_size < SIZE && ftruncate(fd, SIZE) < 0)) {
+                    ::close(fd);
+                    return false;
+                }
+
+                void * map = mmap(NULL, SIZE, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED, fd, 0);
+
+                // The mapping keeps the file open
+                ::close(fd);
+
+                if (map == MAP_FAILED) {
+                    return false;
+                }
+
+                _map = (uint8_t *)map;
+
+                return true;
+            }
+
+            bool read(void * dst, uint16_t size)
+            {
+                if (!_map || size > SIZE) {
+                    return false;
+                }
+
+                memcpy(dst, _map, size);
+
+                return true;
+            }
+
+            bool write(const void * src, uint16_t size)
+            {
+                if (!_map || size > SIZE) {
+                    return false;
+                }
+
+                memcpy(_map, src, size);
+
+                return msync(_map, SIZE, MS_SYNC) == 0;
+            }
+
+    }; // class LinuxStorage
+
+    class LinuxSerial : public RealBoard {
+
+        private:
+
+            LinuxPort _primary;
+            LinuxPort _telemetry;
+
+            LinuxStorage _storage;
+
+        protected:
+
+            const char * _ptyName = NULL;
+
+            // link: optional fixed path for the primary pseudo-terminal
+            // telemetryPath: optional Unix socket path for telemetry
+            // storagePath: optional file for the parameter image
+            LinuxSerial(const char * link=NULL,
+                        const char * telemetryPath=NULL,
+                        const char * storagePath=NULL)
+            {
+                _ptyName = _primary.openPty(link);
+
+                if (telemetryPath) {
+                    _telemetry.listenUnix(telemetryPath);
+                }
+
+                if (storagePath && !_storage.open(storagePath)) {
+                    fprintf(stderr, "Can't map %s\n", storagePath);
+                }
+            }
+
+            uint8_t serialAvailable(bool useTelemetryPort)
+            {
+                return useTelemetryPort ?
+                    _telemetry.available() : _primary.available();
+            }
+
+            uint8_t serialRead(bool useTelemetryPort)
+            {
+                return useTelemetryPort ? _telemetry.read() : _primary.read();
+            }
+
+            void serialWrite(uint8_t byte, bool useTelemetryPort)
+            {
+                if (useTelemetryPort) {
+                    _telemetry.write(byte);
+                }
+                else {
+                    _primary.write(byte);
+                }
+            }
+
+            void serialFlush(bool useTelemetryPort) override
+            {
+                if (useTelemetryPort) {
+                    _telemetry.flush();
+                }
+                else {
+                    _primary.flush();
+                }
+            }
+
+            void setLed(bool isOn)
+            {
+                (void)isOn;
+            }
+
+            bool storageRead(void * dst, uint16_t size) override
+            {
+                return _storage.read(dst, size);
+            }
+
+            bool storageWrite(const void * src, uint16_t size) override
+            {
+                return _storage.write(src, size);
+            }
+
+            void begin(void)
+            {
+                if (_ptyName) {
+                    fprintf(stderr, "Serial port: %s\n", _ptyName);
+                }
+
+                // Turns the LED off, ready for the startup flashing
+                RealBoard::begin();
+            }
+
+        public:
+
+            uint32_t droppedBytes(bool useTelemetryPort)
+            {
+                return useTelemetryPort ?
+                    _telemetry.dropped : _primary.dropped;
+            }
+
+    }; // class LinuxSerial
+
+    void Debugger::outbuf(char * buf)
+    {
+        fputs(buf, stdout);
+    }
+
+} // namespace rft
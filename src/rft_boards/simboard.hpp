@@ -0,0 +1,74 @@
+/*
+   Board subclass for simulation, with a virtual clock
+
+   The clock advances only when step() is called, so a simulation can run as
+   fast as the host allows and still see exactly the timing it would see in
+   real time.  step() also fires the timer callback, as a hardware timer
+   interrupt would, whether or not the firmware's loop is being run.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "RFT_board.hpp"
+
+namespace rft {
+
+    class SimBoard : public Board {
+
+        private:
+
+            float _dt = 0;
+            uint32_t _ticks = 0;
+
+            void (*_timerCallback)(void *) = NULL;
+            void * _timerContext = NULL;
+            uint32_t _timerTicks = 0;
+
+        protected:
+
+            float getTime(void) override
+            {
+                return _ticks * _dt;
+            }
+
+            bool startTimer(float period,
+                            void (*callback)(void *),
+                            void * context) override
+            {
+                _timerTicks = (uint32_t)(period / _dt + 0.5f);
+                _timerTicks = _timerTicks > 0 ? _timerTicks : 1;
+                _timerCallback = callback;
+                _timerContext = context;
+                return true;
+            }
+
+        public:
+
+            SimBoard(float dt=0.001)
+            {
+                _dt = dt;
+            }
+
+            void step(void)
+            {
+                _ticks++;
+
+                if (_timerCallback && _ticks % _timerTicks == 0) {
+                    _timerCallback(_timerContext);
+                }
+            }
+
+            float dt(void)
+            {
+                return _dt;
+            }
+
+    }; // class SimBoard
+
+} // namespace rft
@@ -0,0 +1,267 @@
+/*
+   PID control with precomputed discrete-time coefficients
+
+   Pid does the arithmetic: gains and loop rate are folded into per-tick
+   coefficients whenever they change, so compute() is multiply-adds and
+   clamps only.  The derivative acts on the measurement through a first-order
+   low-pass filter, and the integral is clamped and frozen while the output
+   saturates.  PidSchedule interpolates gains from a table indexed by, e.g.,
+   throttle or airspeed.  PidController wraps a Pid as a ClosedLoopController,
+   optionally taking its gains from a ParameterStore so that they can be
+   tuned over MSP.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include "RFT_filters.hpp"
+#include "RFT_closedloop.hpp"
+#include "RFT_params.hpp"
+
+namespace rft {
+
+    class Pid {
+
+        private:
+
+            static constexpr float PI_F = 3.14159265f;
+
+            // Gains
+            float _kp = 0;
+            float _ki = 0;
+            float _kd = 0;
+
+            // Constants depending only on rate and derivative cutoff
+            float _dt = 0;
+            float _dAlpha = 0;   // tau / (tau + dt)
+            float _dScale = 0;   // 1 / (tau + dt)
+
+            // Per-tick coefficients
+            float _ciDt = 0;     // ki * dt
+            float _cd = 0;       // kd / (tau + dt)
+
+            float _integralMax = 0;
+            float _outputMax = 0;
+
+            // State
+            float _integral = 0;
+            float _derivative = 0;
+            float _lastMeasurement = 0;
+            bool _haveLast = false;
+
+            void updateCoefficients(void)
+            {
+                _ciDt = _ki * _dt;
+                _cd = _kd * _dScale;
+            }
+
+        public:
+
+            Pid(float kp=0, float ki=0, float kd=0,
+                float rate=300, float derivativeCutoff=40,
+                float integralMax=1, float outputMax=1)
+            {
+                _integralMax = integralMax;
+                _outputMax = outputMax;
+                setRate(rate, derivativeCutoff);
+                setGains(kp, ki, kd);
+            }
+
+            void setRate(float rate, float derivativeCutoff)
+            {
+                float tau = 1 / (2 * PI_F * derivativeCutoff);
+                _dt = 1 / rate;
+                _dScale = 1 / (tau + _dt);
+                _dAlpha = tau * _dScale;
+                updateCoefficients();
+            }
+
+            void setGains(float kp, float ki, float kd)
+            {
+                _kp = kp;
+                _ki = ki;
+                _kd = kd;
+                updateCoefficients();
+            }
+
+            void reset(void)
+            {
+                _integral = 0;
+                _derivative = 0;
+                _haveLast = false;
+            }
+
+            float compute(float target, float measurement)
+            {
+                float error = target - measurement;
+
+                // Derivative on measurement avoids a kick on setpoint steps
+                float delta = _haveLast ? measurement - _lastMeasurement : 0;
+                _derivative = _dAlpha * _derivative - _cd * delta;
+                _lastMeasurement = measurement;
+                _haveLast = true;
+
+                float integral = Filter::constrainAbs(
+                        _integral + _ciDt * error, _integralMax);
+
+                float output = _kp * error + integral + _derivative;
+                float clamped = Filter::constrainAbs(output, _outputMax);
+
+                // Anti-windup: keep the integral only if it isn't pushing
+                // further into saturation
+                if (clamped == output || error * output < 0) {
+                    _integral = integral;
+                }
+
+                return clamped;
+            }
+
+    }; // class Pid
+
+    template <uint8_t SIZE> class PidSchedule {
+
+        private:
+
+            float _x[SIZE] = {};
+            float _gains[SIZE][3] = {};
+
+            // Gain change per unit of x over each segment
+            float _slopes[SIZE][3] = {};
+
+            uint8_t _count = 0;
+
+        public:
+
+            // Breakpoints must be added in increasing order of x; one that
+            // isn't, or that doesn't fit, is ignored
+            void add(float x, float kp, float ki, float kd)
+            {
+                if (_count == SIZE || (_count > 0 && !(x > _x[_count-1]))) {
+                    return;
+                }
+
+                _x[_count] = x;
+                _gains[_count][0] = kp;
+                _gains[_count][1] = ki;
+                _gains[_count][2] = kd;
+
+                if (_count > 0) {
+                    float scale = 1 / (x - _x[_count-1]);
+                    for (uint8_t k=0; k<3; ++k) {
+                        _slopes[_count-1][k] =
+                            (_gains[_count][k] - _gains[_count-1][k]) * scale;
+                    }
+                }
+
+                _count++;
+            }
+
+            // Interpolates gains at x, holding the end values outside the
+            // table, and applies them to pid
+            void apply(float x, Pid & pid)
+            {
+                if (_count == 0) {
+                    return;
+                }
+
+                uint8_t j = 0;
+                while (j < _count-1 && x > _x[j+1]) {
+                    j++;
+                }
+
+                float dx = Filter::constrainMinMax(x - _x[j], 0,
+                        j < _count-1 ? _x[j+1] - _x[j] : 0);
+
+                pid.setGains(_gains[j][0] + _slopes[j][0] * dx,
+                             _gains[j][1] + _slopes[j][1] * dx,
+                             _gains[j][2] + _slopes[j][2] * dx);
+            }
+
+    }; // class PidSchedule
+
+    class PidController : public ClosedLoopController {
+
+        private:
+
+            ParameterStore * _parameters = NULL;
+            int8_t _gainsIndex = -1;
+            uint16_t _parameterChanges = 0;
+
+            void applyParameters(void)
+            {
+                _parameterChanges = _parameters->changes();
+
+                _pid.setGains(_parameters->getFloat(_gainsIndex),
+                              _parameters->getFloat(_gainsIndex+1),
+                              _parameters->getFloat(_gainsIndex+2));
+            }
+
+        protected:
+
+            Pid _pid;
+
+            uint8_t _demandIndex = 0;
+
+            PidController(uint8_t demandIndex, const Pid & pid)
+                : _pid(pid)
+            {
+                _demandIndex = demandIndex;
+            }
+
+            // The quantity the demand at _demandIndex is a target for
+            virtual float getMeasurement(State * state) = 0;
+
+            // Throttle-down and the like clear the integral
+            virtual void resetOnInactivity(bool inactive) override
+            {
+                if (inactive) {
+                    _pid.reset();
+                }
+            }
+
+            virtual void modifyDemands(State * state, float * demands) override
+            {
+                if (_parameters &&
+                        _parameters->changes() != _parameterChanges) {
+                    applyParameters();
+                }
+
+                demands[_demandIndex] =
+                    _pid.compute(demands[_demandIndex], getMeasurement(state));
+            }
+
+        public:
+
+            // Takes kp, ki and kd from three consecutive parameters starting
+            // at index, e.g. as added by addGains(), whenever they change
+            void useParameters(ParameterStore * parameters, int8_t index)
+            {
+                if (index < 0 || index + 2 >= parameters->count()) {
+                    return;
+                }
+
+                _parameters = parameters;
+                _gainsIndex = index;
+
+                applyParameters();
+            }
+
+            // Adds the three gain parameters, with these defaults, and
+            // returns the index of the first
+            static int8_t addGains(ParameterStore * parameters,
+                    const char * kpName, const char * kiName,
+                    const char * kdName, float kp, float ki, float kd,
+                    float maximum=100)
+            {
+                int8_t index = parameters->addFloat(kpName, kp, 0, maximum);
+                parameters->addFloat(kiName, ki, 0, maximum);
+                return parameters->addFloat(kdName, kd, 0, maximum) < 0 ?
+                    -1 : index;
+            }
+
+    }; // class PidController
+
+} // namespace rft
@@ -0,0 +1,135 @@
+/*
+   EKF estimating altitude and vertical velocity from an earth-frame
+   vertical accelerometer, a barometer, and an optional rangefinder
+
+   State is altitude (m), vertical velocity (m/s), and accelerometer bias
+   (m/s^2), all positive upward.  A Sensor typically owns one of these,
+   calling predict() and the update methods from modifyState() and copying
+   altitude() and velocity() into the vehicle's State.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include "RFT_ekf.hpp"
+
+namespace rft {
+
+    class AltitudeEstimator : public ExtendedKalmanFilter<3, 16> {
+
+        private:
+
+            // Barometer reads altitude directly
+            class Baro : public EkfMeasurement<3> {
+
+                public:
+
+                    float predict(const Vec<3> & x, Vec<3> & H) override
+                    {
+                        H[0] = 1;
+                        H[1] = 0;
+                        H[2] = 0;
+                        return x[0];
+                    }
+            };
+
+            // Downward rangefinder reads altitude over the cosine of tilt
+            class Range : public EkfMeasurement<3> {
+
+                public:
+
+                    float cosTilt = 1;
+
+                    float predict(const Vec<3> & x, Vec<3> & H) override
+                    {
+                        H[0] = 1 / cosTilt;
+                        H[1] = 0;
+                        H[2] = 0;
+                        return x[0] / cosTilt;
+                    }
+            };
+
+            // Below this cosine of tilt the rangefinder misses the ground
+            static constexpr float MIN_COS_TILT = 0.7;
+
+            Baro _baro;
+            Range _range;
+
+            float _accel = 0;
+            float _accelVariance = 0;
+            float _biasVariance = 0;
+
+        protected:
+
+            void transition(float dt, Mat<3,3> & F, SymMat<3> & Q) override
+            {
+                float a = _accel - _x[2];
+                float hdt2 = 0.5f * dt * dt;
+
+                _x[0] += _x[1] * dt + a * hdt2;
+                _x[1] += a * dt;
+
+                F(0,1) = dt;
+                F(0,2) = -hdt2;
+                F(1,2) = -dt;
+
+                // Acceleration noise enters through [dt^2/2, dt, 0]
+                Q(0,0) = _accelVariance * hdt2 * hdt2;
+                Q(1,0) = _accelVariance * hdt2 * dt;
+                Q(1,1) = _accelVariance * dt * dt;
+                Q(2,2) = _biasVariance * dt;
+            }
+
+        public:
+
+            AltitudeEstimator(float accelStdDev=0.5, float biasStdDev=0.01)
+            {
+                _accelVariance = accelStdDev * accelStdDev;
+                _biasVariance = biasStdDev * biasStdDev;
+
+                _P(0,0) = 1;
+                _P(1,1) = 1;
+                _P(2,2) = 0.1;
+            }
+
+            // accel is earth-frame vertical acceleration with gravity removed
+            void predict(float dt, float accel)
+            {
+                _accel = accel;
+                ExtendedKalmanFilter<3, 16>::predict(dt);
+            }
+
+            bool updateBaro(float altitude, float stdDev=0.5)
+            {
+                return update(_baro, altitude, stdDev * stdDev);
+            }
+
+            // delay is the rangefinder's latency in seconds
+            bool updateRange(float range, float cosTilt, float stdDev=0.05,
+                             float delay=0)
+            {
+                if (cosTilt < MIN_COS_TILT) {
+                    return false;
+                }
+
+                _range.cosTilt = cosTilt;
+
+                return updateDelayed(_range, range, stdDev * stdDev, delay);
+            }
+
+            float altitude(void) const
+            {
+                return _x[0];
+            }
+
+            float velocity(void) const
+            {
+                return _x[1];
+            }
+
+    }; // class AltitudeEstimator
+
+} // namespace rft
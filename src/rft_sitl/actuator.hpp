@@ -0,0 +1,89 @@
+/*
+   Actuator that mixes demands onto the motors of a QuadPlant
+
+   Demands are throttle in [0,1] followed by roll, pitch and yaw in [-1,+1],
+   each positive in the aerospace sense (right wing down, nose up, nose
+   right).
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include "RFT_actuator.hpp"
+#include "RFT_filters.hpp"
+#include "rft_sitl/quadplant.hpp"
+
+namespace rft {
+
+    class SimQuadActuator : public Actuator {
+
+        private:
+
+            QuadPlant * _plant = NULL;
+
+            float _disarmed[4] = {};
+
+            void write(const float motors[4])
+            {
+                for (uint8_t k=0; k<4; ++k) {
+                    _plant->setMotor(k, motors[k]);
+                }
+            }
+
+        protected:
+
+            virtual void runDisarmed(void) override
+            {
+                write(_disarmed);
+            }
+
+            virtual void cut(void) override
+            {
+                float zeros[4] = {};
+                write(zeros);
+            }
+
+        public:
+
+            SimQuadActuator(QuadPlant * plant)
+            {
+                _plant = plant;
+            }
+
+            virtual void run(float * demands, bool olcInactive) override
+            {
+                if (!olcInactive) {
+                    cut();
+                    return;
+                }
+
+                // Rows: motor; columns: throttle, roll, pitch, yaw
+                static const float MIX[4][4] = {
+                    { +1, -1, -1, +1 },  // 1 right rear, CCW
+                    { +1, -1, +1, -1 },  // 2 right front, CW
+                    { +1, +1, -1, -1 },  // 3 left rear, CW
+                    { +1, +1, +1, +1 },  // 4 left front, CCW
+                };
+
+                float motors[4] = {};
+                for (uint8_t k=0; k<4; ++k) {
+                    for (uint8_t j=0; j<4; ++j) {
+                        motors[k] += MIX[k][j] * demands[j];
+                    }
+                    motors[k] = Filter::constrainMinMax(motors[k], 0, 1);
+                }
+
+                write(motors);
+            }
+
+            virtual void setMotorDisarmed(uint8_t index, float value) override
+            {
+                _disarmed[index] = value;
+            }
+
+    }; // class SimQuadActuator
+
+} // namespace rft
@@ -0,0 +1,200 @@
+/*
+   Six-degree-of-freedom rigid-body model of a quad-X multirotor
+
+   Earth frame is North-East-Down and body frame is Forward-Right-Down, so
+   angles follow the usual aerospace conventions.  Motors are numbered as:
+
+       4 (CCW)   2 (CW)
+             \   /
+              \ /        forward is up the page
+              / \
+             /   \
+       3 (CW)    1 (CCW)
+
+   Each motor's speed follows its command through a first-order lag, and its
+   thrust goes as speed squared.  The model integrates with a fixed step using
+   semi-implicit Euler, and rests on the ground at zero altitude.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+namespace rft {
+
+    class QuadPlant {
+
+        public:
+
+            static constexpr float G = 9.80665;
+
+            class Params {
+
+                public:
+
+                    float mass = 0.6;            // kg
+                    float arm = 0.12;            // m, center to motor
+                    float ixx = 3.0e-3;          // kg m^2
+                    float iyy = 3.0e-3;
+                    float izz = 5.0e-3;
+                    float maxThrust = 4.0;       // N per motor
+                    float torquePerThrust = 0.016; // m, yaw torque / thrust
+                    float motorTau = 0.03;       // s, motor time constant
+                    float linearDrag = 0.1;      // N / (m/s)
+                    float angularDrag = 2e-3;    // N m / (rad/s)
+            };
+
+            // Ground truth
+            float position[3] = {};     // m, NED
+            float velocity[3] = {};     // m/s, NED
+            float quaternion[4] = {1, 0, 0, 0}; // body to earth
+            float omega[3] = {};        // rad/s, body
+            float accel[3] = {};        // m/s^2, NED, last step
+            float motors[4] = {};       // normalized speeds in [0,1]
+
+        private:
+
+            Params _p;
+
+            float _commands[4] = {};
+
+            // v_earth = R v_body
+            void rotate(const float b[3], float e[3])
+            {
+                float w = quaternion[0];
+                float x = quaternion[1];
+                float y = quaternion[2];
+                float z = quaternion[3];
+
+                e[0] = (1-2*(y*y+z*z))*b[0] + 2*(x*y-w*z)*b[1] + 2*(x*z+w*y)*b[2];
+                e[1] = 2*(x*y+w*z)*b[0] + (1-2*(x*x+z*z))*b[1] + 2*(y*z-w*x)*b[2];
+                e[2] = 2*(x*z-w*y)*b[0] + 2*(y*z+w*x)*b[1] + (1-2*(x*x+y*y))*b[2];
+            }
+
+        public:
+
+            QuadPlant(void)
+            {
+            }
+
+            QuadPlant(const Params & params)
+                : _p(params)
+            {
+            }
+
+            // Normalized motor commands in [0,1]
+            void setMotor(uint8_t index, float command)
+            {
+                _commands[index] = command < 0 ? 0 : command > 1 ? 1 : command;
+            }
+
+            float altitude(void) const
+            {
+                return -position[2];
+            }
+
+            // v_body = R' v_earth
+            void earthToBody(const float e[3], float b[3]) const
+            {
+                float w = quaternion[0];
+                float x = quaternion[1];
+                float y = quaternion[2];
+                float z = quaternion[3];
+
+                b[0] = (1-2*(y*y+z*z))*e[0] + 2*(x*y+w*z)*e[1] + 2*(x*z-w*y)*e[2];
+                b[1] = 2*(x*y-w*z)*e[0] + (1-2*(x*x+z*z))*e[1] + 2*(y*z+w*x)*e[2];
+                b[2] = 2*(x*z+w*y)*e[0] + 2*(y*z-w*x)*e[1] + (1-2*(x*x+y*y))*e[2];
+            }
+
+            void step(float dt)
+            {
+                // Motor positions (x forward, y right) and spin directions,
+                // with +1 for CCW props whose reaction torque yaws nose right
+                static const float MX[4] = {-1, +1, -1, +1};
+                static const float MY[4] = {+1, +1, -1, -1};
+                static const float SPIN[4] = {+1, -1, -1, +1};
+
+                // Motor lag and thrust
+                float alpha = dt / (_p.motorTau + dt);
+                float thrust = 0;
+                float torque[3] = {};
+                float d = _p.arm * 0.70710678f;
+
+                for (uint8_t k=0; k<4; ++k) {
+
+                    motors[k] += alpha * (_commands[k] - motors[k]);
+
+                    float t = _p.maxThrust * motors[k] * motors[k];
+
+                    thrust += t;
+
+                    // Thrust (0,0,-t) at (x,y,0) gives torque (-y t, x t, 0)
+                    torque[0] -= MY[k] * d * t;
+                    torque[1] += MX[k] * d * t;
+                    torque[2] += SPIN[k] * _p.torquePerThrust * t;
+                }
+
+                // Rotational dynamics: I w' = tau - w x Iw - drag w
+                float I[3] = {_p.ixx, _p.iyy, _p.izz};
+                float Iw[3] = {I[0]*omega[0], I[1]*omega[1], I[2]*omega[2]};
+                float gyro[3] = {
+                    omega[1]*Iw[2] - omega[2]*Iw[1],
+                    omega[2]*Iw[0] - omega[0]*Iw[2],
+                    omega[0]*Iw[1] - omega[1]*Iw[0]
+                };
+                for (uint8_t k=0; k<3; ++k) {
+                    omega[k] += dt * (torque[k] - gyro[k] -
+                            _p.angularDrag * omega[k]) / I[k];
+                }
+
+                // Attitude: q' = q (x) (0, w) / 2
+                float w = quaternion[0];
+                float x = quaternion[1];
+                float y = quaternion[2];
+                float z = quaternion[3];
+                float h = 0.5f * dt;
+                quaternion[0] += h * (-x*omega[0] - y*omega[1] - z*omega[2]);
+                quaternion[1] += h * ( w*omega[0] + y*omega[2] - z*omega[1]);
+                quaternion[2] += h * ( w*omega[1] - x*omega[2] + z*omega[0]);
+                quaternion[3] += h * ( w*omega[2] + x*omega[1] - y*omega[0]);
+                float n = 1 / sqrtf(quaternion[0]*quaternion[0] +
+                        quaternion[1]*quaternion[1] +
+                        quaternion[2]*quaternion[2] +
+                        quaternion[3]*quaternion[3]);
+                for (uint8_t k=0; k<4; ++k) {
+                    quaternion[k] *= n;
+                }
+
+                // Translational dynamics
+                float fb[3] = {0, 0, -thrust};
+                float fe[3] = {};
+                rotate(fb, fe);
+                for (uint8_t k=0; k<3; ++k) {
+                    accel[k] = (fe[k] - _p.linearDrag * velocity[k]) / _p.mass;
+                }
+                accel[2] += G;
+
+                for (uint8_t k=0; k<3; ++k) {
+                    velocity[k] += dt * accel[k];
+                    position[k] += dt * velocity[k];
+                }
+
+                // Ground contact
+                if (position[2] > 0) {
+                    position[2] = 0;
+                    for (uint8_t k=0; k<3; ++k) {
+                        velocity[k] = 0;
+                        accel[k] = 0;
+                        omega[k] = 0;
+                    }
+                }
+            }
+
+    }; // class QuadPlant
+
+} // namespace rft
@@ -0,0 +1,74 @@
+/*
+   Fast, seedable random numbers for simulated sensor noise
+
+   xoshiro128+ for uniforms; Gaussians by summing four uniforms, which is
+   plenty for sensor noise and avoids log/sqrt/trig per sample.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace rft {
+
+    class FastRandom {
+
+        private:
+
+            uint32_t _s[4] = {};
+
+            static uint32_t rotl(uint32_t x, uint8_t k)
+            {
+                return (x << k) | (x >> (32 - k));
+            }
+
+        public:
+
+            FastRandom(uint32_t seed=1)
+            {
+                // Expand the seed with splitmix32
+                for (uint8_t k=0; k<4; ++k) {
+                    seed += 0x9e3779b9;
+                    uint32_t z = seed;
+                    z = (z ^ (z >> 16)) * 0x85ebca6b;
+                    z = (z ^ (z >> 13)) * 0xc2b2ae35;
+                    _s[k] = z ^ (z >> 16);
+                }
+            }
+
+            uint32_t next(void)
+            {
+                uint32_t result = _s[0] + _s[3];
+                uint32_t t = _s[1] << 9;
+
+                _s[2] ^= _s[0];
+                _s[3] ^= _s[1];
+                _s[1] ^= _s[2];
+                _s[0] ^= _s[3];
+                _s[2] ^= t;
+                _s[3] = rotl(_s[3], 11);
+
+                return result;
+            }
+
+            // Uniform in [0,1)
+            float uniform(void)
+            {
+                return (next() >> 8) * (1.0f / 16777216);
+            }
+
+            // Approximately normal with zero mean and the given deviation
+            float gaussian(float stdDev)
+            {
+                // Sum of four uniforms has variance 1/3
+                float sum = uniform() + uniform() + uniform() + uniform();
+                return (sum - 2) * 1.7320508f * stdDev;
+            }
+
+    }; // class FastRandom
+
+} // namespace rft
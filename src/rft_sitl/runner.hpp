@@ -0,0 +1,102 @@
+/*
+   Lockstep software-in-the-loop runner for many independent vehicles
+
+   Each SitlVehicle wraps its own firmware object (e.g., an RFTPure subclass)
+   and plant.  Because RFT objects keep no global state, any number of them
+   can run in one process.  The runner advances every vehicle by a frame of
+   steps in parallel, waits for all of them, and repeats, so results are
+   reproducible regardless of thread count.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <atomic>
+
+#include "rft_sitl/threadpool.hpp"
+
+namespace rft {
+
+    class SitlVehicle {
+
+        friend class SitlRunner;
+
+        private:
+
+            bool _done = false;
+
+        public:
+
+            virtual ~SitlVehicle(void) { }
+
+            virtual void begin(void) { }
+
+            // Advances the simulation one step; returns false when the
+            // flight is over (landed, crashed, timed out, ...)
+            virtual bool step(void) = 0;
+
+    }; // class SitlVehicle
+
+    class SitlRunner {
+
+        private:
+
+            WorkStealingPool & _pool;
+
+        public:
+
+            SitlRunner(WorkStealingPool & pool)
+                : _pool(pool)
+            {
+            }
+
+            // Runs until every vehicle is done or maxSteps have elapsed;
+            // returns the total number of vehicle steps taken
+            uint64_t run(SitlVehicle ** vehicles, uint32_t count,
+                         uint32_t maxSteps, uint32_t stepsPerFrame=100)
+            {
+                std::atomic<uint64_t> total(0);
+
+                _pool.parallelFor(count, [&](uint32_t k) {
+                        vehicles[k]->_done = false;
+                        vehicles[k]->begin();
+                        });
+
+                for (uint32_t step=0; step<maxSteps; step+=stepsPerFrame) {
+
+                    std::atomic<uint32_t> active(0);
+
+                    uint32_t frame = stepsPerFrame < maxSteps - step ?
+                        stepsPerFrame : maxSteps - step;
+
+                    _pool.parallelFor(count, [&](uint32_t k) {
+
+                            SitlVehicle * v = vehicles[k];
+                            uint32_t taken = 0;
+
+                            while (!v->_done && taken < frame) {
+                                v->_done = !v->step();
+                                taken++;
+                            }
+
+                            total += taken;
+
+                            if (!v->_done) {
+                                active++;
+                            }
+                        });
+
+                    if (active == 0) {
+                        break;
+                    }
+                }
+
+                return total;
+            }
+
+    }; // class SitlRunner
+
+} // namespace rft
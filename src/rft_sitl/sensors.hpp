@@ -0,0 +1,128 @@
+/*
+   Simulated IMU and barometer, synthesized from a QuadPlant
+
+   These are Sensors whose modifyState() is left to your subclass, just as a
+   hardware driver leaves it to the vehicle code: call the read methods from
+   modifyState() and store the results in your State.
+
+   A real gyro usually samples faster than it is polled; the decimating
+   readGyrometer() models that by reading several samples per call and
+   running them through a Decimator, as a driver for such a part would.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include "RFT_sensor.hpp"
+#include "RFT_decimator.hpp"
+#include "rft_sitl/quadplant.hpp"
+#include "rft_sitl/random.hpp"
+
+namespace rft {
+
+    class SimImu : public Sensor {
+
+        private:
+
+            FastRandom _random;
+
+            float _gyroNoise = 0;
+            float _accelNoise = 0;
+            float _gyroBias[3] = {};
+
+        protected:
+
+            QuadPlant * _plant = NULL;
+
+            SimImu(QuadPlant * plant,
+                   float gyroNoise=0.005,   // rad/s
+                   float accelNoise=0.05,   // m/s^2
+                   float gyroBias=0.01,     // rad/s, max per axis
+                   uint32_t seed=1)
+                : _random(seed)
+            {
+                _plant = plant;
+                _gyroNoise = gyroNoise;
+                _accelNoise = accelNoise;
+
+                for (uint8_t k=0; k<3; ++k) {
+                    _gyroBias[k] = gyroBias * (2 * _random.uniform() - 1);
+                }
+            }
+
+            // Body rates in rad/s
+            void readGyrometer(float & gx, float & gy, float & gz)
+            {
+                gx = _plant->omega[0] + _gyroBias[0] + _random.gaussian(_gyroNoise);
+                gy = _plant->omega[1] + _gyroBias[1] + _random.gaussian(_gyroNoise);
+                gz = _plant->omega[2] + _gyroBias[2] + _random.gaussian(_gyroNoise);
+            }
+
+            // Body rates in rad/s from a gyro sampling `samples` times per
+            // call, each axis through decimator; returns true when rates[]
+            // has new values, once every Decimator::RATIO samples
+            template <typename D>
+            bool readGyrometer(D & decimator, uint8_t samples, float * rates)
+            {
+                bool ready = false;
+
+                for (uint8_t k=0; k<samples; ++k) {
+                    float g[3] = {};
+                    readGyrometer(g[0], g[1], g[2]);
+                    ready |= decimator.update(g, rates);
+                }
+
+                return ready;
+            }
+
+            // Specific force in body axes, m/s^2; reads (0, 0, -g) at rest
+            void readAccelerometer(float & ax, float & ay, float & az)
+            {
+                float f[3] = {
+                    _plant->accel[0],
+                    _plant->accel[1],
+                    _plant->accel[2] - QuadPlant::G
+                };
+                float b[3] = {};
+                _plant->earthToBody(f, b);
+
+                ax = b[0] + _random.gaussian(_accelNoise);
+                ay = b[1] + _random.gaussian(_accelNoise);
+                az = b[2] + _random.gaussian(_accelNoise);
+            }
+
+    }; // class SimImu
+
+    class SimBaro : public Sensor {
+
+        private:
+
+            FastRandom _random;
+
+            float _noise = 0;
+
+        protected:
+
+            QuadPlant * _plant = NULL;
+
+            SimBaro(QuadPlant * plant,
+                    float noise=0.3,  // m
+                    uint32_t seed=2)
+                : _random(seed)
+            {
+                _plant = plant;
+                _noise = noise;
+            }
+
+            // Altitude in m above the starting point
+            float readAltitude(void)
+            {
+                return _plant->altitude() + _random.gaussian(_noise);
+            }
+
+    }; // class SimBaro
+
+} // namespace rft
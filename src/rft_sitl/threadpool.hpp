@@ -0,0 +1,186 @@
+/*
+   Work-stealing thread pool for host (Linux) builds
+
+   parallelFor() splits an index range evenly across the workers.  Each
+   worker consumes its own range from the front; a worker that runs dry
+   steals the back half of the busiest-looking victim's range, so uneven job
+   costs still keep every core busy.
+
+   Copyright (c) 2021 Simon D. Levy
+
+   MIT License
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rft {
+
+    class WorkStealingPool {
+
+        private:
+
+            class Range {
+
+                public:
+
+                    std::mutex lock;
+                    uint32_t begin = 0;
+                    uint32_t end = 0;
+            };
+
+            std::vector<std::thread> _threads;
+            std::vector<Range> _ranges;
+
+            std::function<void(uint32_t)> _job;
+
+            std::mutex _lock;
+            std::condition_variable _start;
+            std::condition_variable _done;
+            uint32_t _generation = 0;
+            uint32_t _busy = 0;
+            bool _quit = false;
+
+            bool take(uint32_t id, uint32_t & index)
+            {
+                Range & r = _ranges[id];
+                std::lock_guard<std::mutex> guard(r.lock);
+
+                if (r.begin == r.end) {
+                    return false;
+                }
+
+                index = r.begin++;
+                return true;
+            }
+
+            bool steal(uint32_t id, uint32_t & index)
+            {
+                uint32_t n = _ranges.size();
+
+                for (uint32_t k=1; k<n; ++k) {
+
+                    Range & victim = _ranges[(id + k) % n];
+                    uint32_t begin = 0, end = 0;
+
+                    {
+                        std::lock_guard<std::mutex> guard(victim.lock);
+                        uint32_t size = victim.end - victim.begin;
+                        if (size == 0) {
+                            continue;
+                        }
+                        end = victim.end;
+                        begin = victim.end - (size + 1) / 2;
+                        victim.end = begin;
+                    }
+
+                    // Run the first stolen index now, keep the rest
+                    Range & mine = _ranges[id];
+                    std::lock_guard<std::mutex> guard(mine.lock);
+                    mine.begin = begin + 1;
+                    mine.end = end;
+                    index = begin;
+                    return true;
+                }
+
+                return false;
+            }
+
+            void work(uint32_t id)
+            {
+                uint32_t generation = 0;
+
+                while (true) {
+
+                    {
+                        std::unique_lock<std::mutex> guard(_lock);
+                        _start.wait(guard, [&] {
+                                return _quit || _generation != generation;
+                                });
+                        if (_quit) {
+                            return;
+                        }
+                        generation = _generation;
+                    }
+
+                    uint32_t index = 0;
+                    while (take(id, index) || steal(id, index)) {
+                        _job(index);
+                    }
+
+                    std::lock_guard<std::mutex> guard(_lock);
+                    if (--_busy == 0) {
+                        _done.notify_one();
+                    }
+                }
+            }
+
+        public:
+
+            WorkStealingPool(uint32_t threads=0)
+            {
+                if (threads == 0) {
+                    threads = std::thread::hardware_concurrency();
+                }
+                if (threads == 0) {
+                    threads = 1;
+                }
+
+                _ranges = std::vector<Range>(threads);
+
+                for (uint32_t k=0; k<threads; ++k) {
+                    _threads.push_back(std::thread(&WorkStealingPool::work,
+                                                   this, k));
+                }
+            }
+
+            ~WorkStealingPool(void)
+            {
+                {
+                    std::lock_guard<std::mutex> guard(_lock);
+                    _quit = true;
+                }
+                _start.notify_all();
+                for (uint32_t k=0; k<_threads.size(); ++k) {
+                    _threads[k].join();
+                }
+            }
+
+            uint32_t size(void) const
+            {
+                return _threads.size();
+            }
+
+            // Runs job(0) ... job(count-1) across the pool and returns when
+            // all have finished
+            void parallelFor(uint32_t count, std::function<void(uint32_t)> job)
+            {
+                uint32_t n = _threads.size();
+
+                std::unique_lock<std::mutex> guard(_lock);
+
+                _job = job;
+
+                for (uint32_t k=0; k<n; ++k) {
+                    std::lock_guard<std::mutex> rguard(_ranges[k].lock);
+                    _ranges[k].begin = (uint64_t)count * k / n;
+                    _ranges[k].end = (uint64_t)count * (k+1) / n;
+                }
+
+                _busy = n;
+                _generation++;
+                _start.notify_all();
+
+                _done.wait(guard, [&] { return _busy == 0; });
+            }
+
+    }; // class WorkStealingPool
+
+} // namespace rft